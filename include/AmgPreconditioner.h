@@ -0,0 +1,118 @@
+/*
+ * AmgPreconditioner.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef AMGPRECONDITIONER_H_
+#define AMGPRECONDITIONER_H_
+
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/vector.h>
+
+#include <vector>
+
+using namespace dealii;
+using namespace std;
+
+namespace femocs {
+
+/** @brief Smoothed aggregation algebraic multigrid preconditioner for symmetric positive definite matrices.
+ * The hierarchy of coarse matrices is built only from the matrix entries, so no external library is needed.
+ * One application of the preconditioner is a V-cycle with forward Gauss-Seidel pre-smoothing
+ * and backward Gauss-Seidel post-smoothing. This keeps the preconditioner symmetric, as required by CG.
+ * The coarsest system is solved with dense Cholesky decomposition.
+ */
+class AmgPreconditioner {
+public:
+    /** Parameters that control the building of hierarchy */
+    struct AdditionalData {
+        AdditionalData(const double threshold=0.02, const int n_coarse=500,
+                const int max_levels=10, const int n_smooth=1);
+
+        double threshold;   ///< min ratio |a_ij| / sqrt(a_ii * a_jj) for strongly connected dofs
+        int n_coarse;       ///< max # rows in the coarsest matrix, that is solved directly
+        int max_levels;     ///< max # levels in the hierarchy
+        int n_smooth;       ///< # Gauss-Seidel sweeps before and after the coarse grid correction
+    };
+
+    AmgPreconditioner() {}
+
+    /** Build the multigrid hierarchy for the matrix. Must be called again if the matrix changes. */
+    void initialize(const SparseMatrix<double> &matrix, const AdditionalData &data=AdditionalData());
+
+    /** Apply the preconditioner, i.e perform one V-cycle for the equation A * dst = src */
+    void vmult(Vector<double> &dst, const Vector<double> &src) const;
+
+    /** Release the memory of the hierarchy */
+    void clear();
+
+    /** Return # levels in the hierarchy */
+    int get_n_levels() const { return levels.size(); }
+
+    /** Return the ratio of total # non-zeros in all levels and # non-zeros in the original matrix */
+    double get_operator_complexity() const;
+
+private:
+    /** Sparse matrix in compressed row storage; the column indices within a row are not sorted */
+    struct CsrMatrix {
+        int n_rows = 0;
+        int n_cols = 0;
+        vector<int> starts;     ///< index of the first entry of every row; size is n_rows + 1
+        vector<int> cols;       ///< column indices of the entries
+        vector<double> vals;    ///< values of the entries
+
+        int nnz() const { return cols.size(); }
+
+        /** Calculate dst = this * src */
+        void vmult(double* dst, const double* src) const;
+
+        /** Calculate dst += this * src */
+        void vmult_add(double* dst, const double* src) const;
+
+        /** Return the transpose of the matrix */
+        CsrMatrix transpose() const;
+
+        /** Return the product this * B */
+        CsrMatrix multiply(const CsrMatrix &B) const;
+    };
+
+    /** Matrices and work vectors of one level of the hierarchy */
+    struct Level {
+        CsrMatrix A;                ///< system matrix
+        CsrMatrix P;                ///< prolongation from the next coarser level
+        CsrMatrix R;                ///< restriction to the next coarser level
+        vector<double> inv_diag;    ///< inverse of the diagonal of A
+        mutable vector<double> x, b, r;  ///< solution, rhs and residual during V-cycle
+    };
+
+    AdditionalData data;
+    vector<Level> levels;               ///< hierarchy from finest to coarsest level
+    vector<double> cholesky;            ///< Cholesky factor of the coarsest matrix in row-major format
+
+    /** Calculate the inverse of the diagonal of the level matrix; for zero diagonal the inverse is 0 */
+    void calc_inv_diag(Level &level) const;
+
+    /** Group the strongly connected dofs into aggregates.
+     * @return # aggregates; for the dofs without strong connections the aggregate index is -1 */
+    int aggregate(const Level &level, vector<int> &aggregates) const;
+
+    /** Build the prolongator by smoothing the piecewise constant interpolation with a damped Jacobi step */
+    void calc_prolongator(Level &level, const vector<int> &aggregates, const int n_aggregates) const;
+
+    /** Calculate and store the Cholesky factor of the dense coarsest matrix */
+    void factorize_coarsest();
+
+    /** Solve the coarsest system using its Cholesky factor */
+    void solve_coarsest(double* x, const double* b) const;
+
+    /** Perform one V-cycle on the given and all the coarser levels */
+    void vcycle(const unsigned int l) const;
+
+    /** Gauss-Seidel sweep over the rows in forward or backward order */
+    void gauss_seidel(const Level &level, const bool forward) const;
+};
+
+} // namespace femocs
+
+#endif /* AMGPRECONDITIONER_H_ */
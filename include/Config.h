@@ -115,6 +115,10 @@ public:
     struct Field {
         double E0;             ///< Value of long range electric field (Active in case of Neumann anodeBC
         double ssor_param;     ///< Parameter for SSOR preconditioner in DealII
+        string preconditioner; ///< Preconditioner for Conjugate Gradient solver; ssor, ssor_float, amg or none; chebyshev if matrix_free
+        /** Use matrix-free Laplace operator instead of sparse matrix. It is always preconditioned
+         * with Chebyshev-Jacobi (or nothing if preconditioner is "none"), so ssor, ssor_float and amg are ignored. */
+        bool matrix_free;
         double cg_tolerance;   ///< Maximum allowed electric potential error
         int n_cg;              ///< Maximum number of Conjugate Gradient iterations in phi calculation
         double V0;             ///< Applied voltage at the anode (active in case of SC emission and Dirichlet anodeBC
@@ -126,15 +130,20 @@ public:
 
     /** Heating module configuration parameters */
     struct Heating {
-        string mode;                ///< Method to calculate current density and temperature; none, stationary or transient
+        string mode;                ///< Method to calculate current density and temperature; none, transient, converge or steady
         string rhofile;             ///< Path to the file with resistivity table
         double lorentz;             ///< Lorentz number (Wiedemenn-Franz law)
         double t_ambient;           ///< Ambient temperature in heat calculations
         int n_cg;                   ///< Max # Conjugate-Gradient iterations
         double cg_tolerance;        ///< Solution accuracy in Conjugate-Gradient solver
         double ssor_param;          ///< Parameter for SSOR preconditioner in DealII. Its fine tuning optimises calculation time.
+        string preconditioner;      ///< Preconditioner for Conjugate Gradient solver; ssor, ssor_float, amg or none
+        string time_scheme;         ///< Time integration scheme of heat equation; euler or crank-nicolson
+        int n_newton;               ///< Max # Newton iterations in steady heat mode
+        double newton_tolerance;    ///< Residual norm relative to the heat sources needed for Newton iterations to converge
         double delta_time;          ///< Timestep of time domain integration [fs]
         double dt_max;              ///< Maximum allowed timestep for heat convergence run
+        double dt_tolerance;        ///< Max local temperature error of adaptive heat time step [K]; 0 turns adaptivity off
         double tau;                 ///< Time constant in Berendsen thermostat
         double T_min;               ///< Minimum allowed temperature [K]
         double T_max;               ///< Maximum allowed temperature [K]
@@ -148,6 +157,11 @@ public:
         double omega;         ///< Voltage correction factor for SC-limited emission calculation; <= 0 ignores SC
         double J_min;         ///< Minimum current density from single face [amps/Angstrom^2]
         double J_max;         ///< Maximum current density from single face [amps/Angstrom^2]
+        bool getelec_reentrant; ///< GETELEC may be called from several threads at once; otherwise the calls are serialised
+        double cache_ftol;    ///< Max relative change of field and line potential to reuse previous emission of face; 0 turns caching off
+        double cache_ttol;    ///< Max relative change of temperature to reuse previous emission of face
+        double table_tol;     ///< Max estimated relative error of tabulated current density; 0 turns emission table off
+        string table_file;    ///< Path to the emission table without work function and extension
     } emission;
 
     /** Parameters related to atomic force calculations */
@@ -186,6 +200,14 @@ public:
         bool periodic;         ///< SP-s will be mapped back to simubox in x,y-direction?
         double landau_log;     ///< Landau logarithm
         unsigned int max_injected; ///< Max nr of super particles injected during one step
+        int sort_period;       ///< Nr of PIC steps between sorting SP-s by their cells; 0 turns sorting off
+        int particles_per_cell;  ///< Target nr of SP-s per cell for merging & splitting them; 0 turns population control off
+        int max_subcycles;     ///< Max nr of PIC steps done with frozen field; 1 solves field at every step
+        double subcycle_tol;   ///< Max relative change of space charge that allows skipping the field solve
+        double subcycle_shift; ///< Max displacement of SP-s since last field solve in units of their cell size
+        bool adaptive_dt;      ///< Adapt PIC timestep to particle velocities and plasma frequency?
+        double courant;        ///< Max fraction of cell size that the fastest SP may travel during one adaptive timestep
+        double dt_min;         ///< Min allowed adaptive timestep [fs]; a smaller limit aborts the run
     } pic;
     
     /** Parameters related to SpaceCharge project */
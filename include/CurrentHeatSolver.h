@@ -32,7 +32,7 @@ public:
     virtual ~EmissionSolver() {}
 
     /** Solve the matrix equation using conjugate gradient method */
-    int solve() { return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param); }
+    int solve() { return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param, conf->preconditioner); }
 
     /** Set the pointers for obtaining external data */
     void set_dependencies(PhysicalQuantities *pq, const Config::Heating *conf) {
@@ -81,10 +81,14 @@ private:
     typedef typename DealSolver<dim>::LinearSystem LinearSystem;
     typedef typename DealSolver<dim>::ScratchData ScratchData;
     typedef typename DealSolver<dim>::CopyData CopyData;
+    typedef typename DealSolver<dim>::CellGeometry CellGeometry;
 
     // TODO figure out what is written
     void write_vtk(ofstream& out) const;
 
+    /** Short name of the solver used in the solver log file */
+    string get_name() const { return "current"; }
+
     /** Calculate the contribution of one cell into global matrix and rhs vector */
     void assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
             ScratchData &scratch_data, CopyData &copy_data) const;
@@ -99,44 +103,81 @@ public:
     HeatSolver(Triangulation<dim> *tria, const CurrentSolver<dim> *cs, vector<double>* bc_values);
 
     /** Assemble the matrix equation for temperature calculation
-     * using Crank-Nicolson or implicit Euler time integration method. */
+     * using Crank-Nicolson or implicit Euler time integration method.
+     * The previous temperature is taken from the current solution vector. */
     void assemble(const double delta_time);
 
-    /** Initialize data vectors and matrices */
+    /** Advance the temperature by one time step with both implicit Euler and Crank-Nicolson method.
+     * The Crank-Nicolson solution is stored into solution vector and the difference between
+     * the two solutions is used as the estimate of the local error of the step.
+     * @param delta_time  time step [sec]
+     * @param n_cg        # CG iterations of the Crank-Nicolson solve; negative if the solver did not converge
+     * @return            max difference between the two solutions [K]
+     */
+    double solve_embedded(const double delta_time, int &n_cg);
+
+    /** Restore the state before the last call of solve_embedded */
+    void reject_step();
+
+    /** Initialize data vectors and matrices and calculate the geometry of cells
+     * that is reused by the heat and current solvers until the mesh changes */
     void setup_system();
 
 private:
     // TODO shouldn't it be temperature dependent?
     static constexpr double cu_rho_cp = 3.4496e-24;  ///< volumetric heat capacity of copper [J/(K*Ang^3)]
     double one_over_delta_time;      ///< inverse of heat solver time step [1/sec]
+    bool steady_jacobian;            ///< assemble also the Jacobian of stationary heat equation
     Vector<double> joule_heat;       ///< integral Joule heat at dofs [Watt]
     Vector<double> total_heat;       ///< integral Joule+Nottingham heat at dofs [Watt]
+    Vector<double> prev_potential;   ///< current solver solution during previous Crank-Nicolson step
+    Vector<double> prev_surface_heat; ///< integral Nottingham heat at dofs during previous Crank-Nicolson step [Watt]
+    Vector<double> saved_solution;   ///< temperature before the last embedded step
+    Vector<double> saved_prev_potential; ///< prev_potential before the last embedded step
+    Vector<double> saved_prev_surface_heat; ///< prev_surface_heat before the last embedded step
     const CurrentSolver<dim>* current_solver;
 
     typedef typename DealSolver<dim>::LinearSystem LinearSystem;
     typedef typename DealSolver<dim>::ScratchData ScratchData;
     typedef typename DealSolver<dim>::CopyData CopyData;
+    typedef typename DealSolver<dim>::CellGeometry CellGeometry;
 
-    /** @brief assemble the matrix equation for temperature calculation using Crank-Nicolson time integration method
-     * Calculate sparse matrix elements and right-hand-side vector
-     * according to the time dependent heat equation weak formulation and to the boundary conditions.
-     */
-    void assemble_crank_nicolson(const double delta_time);
+    CellGeometry cell_geometry;      ///< shape functions & integration weights shared with current solver
 
-    /** @brief assemble the matrix equation for temperature calculation using implicit Euler time integration method
-     * Calculate sparse matrix elements and right-hand-side vector
-     * according to the time dependent heat equation weak formulation and to the boundary conditions.
-     */
-    void assemble_euler_implicit(const double delta_time);
+    /** Assemble the matrix equation with Crank-Nicolson or implicit Euler time integration method */
+    void assemble(const double delta_time, const bool crank_nicolson);
 
-    /** Calculate the contribution of one cell into global matrix and rhs vector */
+    /** Calculate the contribution of one cell into global matrix and rhs vector
+     * using implicit Euler time integration method */
     void assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
             ScratchData &scratch_data, CopyData &copy_data) const;
 
+    /** Calculate the contribution of one cell into global matrix and rhs vector
+     * using Crank-Nicolson time integration method.
+     * Heat conduction is averaged over the previous and the next temperature,
+     * Joule heat over the previous and the current potential. */
+    void assemble_local_cell_crank_nicolson(const typename DoFHandler<dim>::active_cell_iterator &cell,
+            ScratchData &scratch_data, CopyData &copy_data) const;
+
+    /** Calculate the contribution of one cell into the residual and optionally into the Jacobian
+     * of the stationary heat equation */
+    void assemble_local_cell_steady(const typename DoFHandler<dim>::active_cell_iterator &cell,
+            ScratchData &scratch_data, CopyData &copy_data) const;
+
+    /** Assemble the residual of the stationary heat equation for the temperature in solution vector
+     * into the rhs vector with minus sign and optionally the Jacobian of the residual into system matrix.
+     * The Dirichlet boundary conditions are not applied to the matrix.
+     * @return l2-norm of the residual without the Dirichlet dofs */
+    double assemble_steady(const bool with_jacobian);
+
     /** Output the temperature [K] and electrical conductivity [1/(Ohm*nm)] in vtk format */
     void write_vtk(ofstream& out) const;
 
+    /** Short name of the solver used in the solver log file */
+    string get_name() const { return "heat"; }
+
     friend class CurrentHeatSolver<dim> ;
+    friend class CurrentSolver<dim> ;
 };
 
 // Forward declaration to avoid including header
@@ -157,6 +198,15 @@ public:
     /** Setup current and heat solvers */
     void setup(const double temperature);
 
+    /** Find the stationary temperature and current density distribution with Newton iterations,
+     * where every temperature update is damped with backtracking line search.
+     * Iterations stop when the residual is below newton_tolerance times the norm of heat sources.
+     * @param ccg  total # CG iterations in current solver
+     * @param hcg  total # GMRES iterations in heat solver
+     * @return     # Newton iterations; negative if the iterations did not converge
+     */
+    int solve_steady(int &ccg, int &hcg);
+
     /** Obtain number of degrees of freedom in solver */
     int size() const { return heat.size(); }
 
@@ -164,6 +214,9 @@ public:
     CurrentSolver<dim> current;  ///< data and operations for finding current density in material
 
 private:
+    static constexpr double newton_forcing = 1e-3;  ///< tolerance of the linear solve relative to the nonlinear residual
+    static constexpr int n_line_search = 8;         ///< max # halvings of the Newton update during line search
+
     PhysicalQuantities *pq;
     const Config::Heating *conf;
 
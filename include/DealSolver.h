@@ -10,12 +10,15 @@
 
 #include <deal.II/grid/grid_reordering.h>
 #include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_control.h>
 #include <deal.II/hp/fe_values.h>
 
 #include <fstream>
 #include "Globals.h"
 #include "Medium.h"
 #include "FileWriter.h"
+#include "AmgPreconditioner.h"
 
 using namespace dealii;
 using namespace std;
@@ -125,6 +128,14 @@ public:
         }
     } stat;
 
+    /** Statistics about the last solution of the matrix equation */
+    struct SolverStats {
+        int n_iter = 0;           ///< # CG iterations; negative if the solver did not converge
+        double res_initial = 0;   ///< residual norm of the initial guess
+        double res_final = 0;     ///< residual norm of the final solution
+        double time = 0;          ///< wall time spent in the solver [s]
+    } solver_stats;
+
 protected:
     static constexpr unsigned int shape_degree = 1;   ///< degree of the shape functions (linear, quadratic etc elements)
     static constexpr unsigned int quadrature_degree = shape_degree + 1;  ///< degree of the Gaussian numerical integration
@@ -141,6 +152,14 @@ protected:
     Vector<double> system_rhs;               ///< right-hand-side of the matrix equation
     Vector<double> solution;                 ///< resulting solution in the mesh nodes
 
+    PreconditionSSOR<> preconditioner;       ///< SSOR preconditioner that is reused while the matrix is unchanged
+    double preconditioner_param;             ///< relaxation parameter of preconditioner; <= 0 if it is not initialized
+    SparseMatrix<float> system_matrix_float; ///< single precision copy of system matrix for preconditioning
+    PreconditionSSOR<SparseMatrix<float>> preconditioner_float;  ///< SSOR preconditioner in single precision
+    double preconditioner_float_param;       ///< relaxation parameter of single precision preconditioner; <= 0 if it is not initialized
+    AmgPreconditioner amg;                   ///< multigrid preconditioner that is reused while the matrix is unchanged
+    bool amg_outdated;                       ///< matrix has changed since the multigrid hierarchy was built
+
     vector<double> dof_volume;               ///< integral of the shape functions
     vector<unsigned> vertex2dof;             ///< map of vertex to dof indices
     vector<unsigned> vertex2cell;            ///< map of vertex to cell indices
@@ -172,10 +191,61 @@ protected:
         CopyData(const unsigned dofs_per_cell, const unsigned n_q_points);
     };
 
+    /** Shape function values, gradients and integration weights in the quadrature points of all the cells.
+     * The data stays the same until the mesh changes and allows to assemble the matrix equation
+     * repeatedly without recalculating the mapping between reference and real cells. */
+    struct CellGeometry {
+        unsigned int n_dofs = 0;            ///< # dofs per cell
+        unsigned int n_q_points = 0;        ///< # quadrature points per cell
+        vector<double> values;              ///< shape function values; the same for all the cells
+        vector<double> jxw;                 ///< Jacobian times quadrature weight in every cell and quadrature point
+        vector<Tensor<1,dim>> grads;        ///< shape function gradients in every cell and quadrature point
+        vector<types::global_dof_index> dofs;  ///< global dof indices of every cell
+
+        /** Return # cells whose data is stored */
+        unsigned int n_cells() const { return n_q_points > 0 ? jxw.size() / n_q_points : 0; }
+
+        /** Return the value of i-th shape function in q-th quadrature point */
+        double shape_value(const unsigned int i, const unsigned int q) const {
+            return values[q * n_dofs + i];
+        }
+
+        /** Return the gradient of i-th shape function in q-th quadrature point of the cell */
+        const Tensor<1,dim>& shape_grad(const size_t cell, const unsigned int i, const unsigned int q) const {
+            return grads[(cell * n_q_points + q) * n_dofs + i];
+        }
+
+        /** Return Jacobian times quadrature weight in q-th quadrature point of the cell */
+        double JxW(const size_t cell, const unsigned int q) const {
+            return jxw[cell * n_q_points + q];
+        }
+
+        /** Return the pointer to the global dof indices of the cell */
+        const types::global_dof_index* dof_indices(const size_t cell) const {
+            return &dofs[cell * n_dofs];
+        }
+
+        /** Calculate the values of a finite element field in the quadrature points of the cell */
+        void get_function_values(const size_t cell, const Vector<double> &field, vector<double> &field_values) const;
+
+        /** Calculate the gradients of a finite element field in the quadrature points of the cell */
+        void get_function_gradients(const size_t cell, const Vector<double> &field, vector<Tensor<1,dim>> &field_grads) const;
+
+        /** Release the memory */
+        void clear();
+    };
+
+    /** Calculate the shape functions and integration weights in all the cells */
+    void calc_cell_geometry(CellGeometry &geometry) const;
+
     /** Copy the matrix & rhs vector contribution of a cell into global matrix & rhs vector */
     // Only one instance of this function should be running at a time!
     void copy_global_cell(const CopyData &copy_data, LinearSystem &system) const;
 
+    /** Copy only the rhs vector contribution of a cell into global rhs vector */
+    // Only one instance of this function should be running at a time!
+    void copy_global_rhs(const CopyData &copy_data, LinearSystem &system) const;
+
     /** Helper function for the public shape_funs */
     vector<double> shape_funs(const Point<dim> &p, const int cell_index, Mapping<dim,dim>& mapping) const;
 
@@ -186,11 +256,34 @@ protected:
      * @param n_steps     maximum number of iterations allowed
      * @param tolerance   tolerance of the solution
      * @param ssor_param  parameter to SSOR preconditioner. Its fine tuning optimises calculation time
+     * @param precond     type of preconditioner; ssor, ssor_float, amg or none
+     * SSOR preconditioner is initialized only if the system matrix has changed since the previous call.
+     * In ssor_float mode, SSOR sweeps are performed with single precision copy of the matrix,
+     * which halves the memory traffic of the preconditioner. CG iterations, and therefore the residual
+     * that is compared against tolerance, are still calculated in double precision.
+     * Like SSOR, AMG hierarchy is reused between the calls and rebuilt only if the system matrix has changed.
+     */
+    int solve_cg(const int n_steps, const double tolerance, const double ssor_param, const string &precond="ssor");
+
+    /** Solve the matrix equation using GMRES method; unlike CG, it allows the matrix to be non-symmetric
+     * @param n_steps     maximum number of iterations allowed
+     * @param tolerance   tolerance of the solution
+     * @param ssor_param  parameter to SSOR preconditioner; <= 0 disables preconditioning
      */
-    int solve_cg(const int n_steps, const double tolerance, const double ssor_param);
+    int solve_gmres(const int n_steps, const double tolerance, const double ssor_param);
 
-    /** Set up dynamic sparsity pattern for calculations */
-    void setup_system();
+    /** Store the statistics about the finished solve and append them to the solver log file
+     * @param control  control object of the solver
+     * @param n_iter   # iterations; negative if the solver did not converge
+     * @param t_start  wall time in the beginning of the solve */
+    void store_solver_stats(const SolverControl &control, const int n_iter, const double t_start);
+
+    /** Short name of the solver used in the solver log file */
+    virtual string get_name() const { return "deal"; }
+
+    /** Set up dynamic sparsity pattern for calculations
+     * @param with_matrix  allocate the sparse system matrix; false for matrix-free solvers */
+    void setup_system(const bool with_matrix=true);
 
     /** Modify the right-hand-side vector of the matrix equation */
     void assemble_rhs(const int bid);
@@ -202,6 +295,11 @@ protected:
      * This should be the last function call to setup the equations, before calling solve(). */
     void apply_dirichlet();
 
+    /** Apply the Dirichlet boundary conditions only to the right-hand-side vector,
+     * assuming the conditions have already been applied to the matrix with apply_dirichlet().
+     * @param rhs_bc  right-hand-side of the constant part of the system after calling apply_dirichlet() */
+    void apply_dirichlet_rhs(const Vector<double> &rhs_bc);
+
     /** Calculate the volumes (dim=3) or areas (dim=2) of dofs used during integration */
     void calc_dof_volumes();
 
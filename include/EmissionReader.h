@@ -8,6 +8,7 @@
 #define EMISSIONREADER_H_
 
 #include "SolutionReader.h"
+#include "EmissionTable.h"
 #include "getelec.h"
 
 
@@ -17,6 +18,20 @@ namespace femocs {
 // forward declaration of Pic for declaring it as a friend
 template<int dim> class Pic;
 
+/** Make the first GETELEC call serially.
+ * The first call reads in/GetelecPar.in and sets up the module data of the library,
+ * so it must not happen in several threads at once. Later calls do nothing. */
+void init_getelec(const double work_function);
+
+/** Calculate emission with GETELEC in a way that is safe to call from OpenMP threads.
+ * GETELEC is a Fortran library with module-level state and nothing guarantees that it is re-entrant.
+ * Therefore the calls are serialised, unless the library is declared re-entrant in the configuration.
+ * @param gt            GETELEC input and output
+ * @param space_charge  use the space charge limited version of the calculation
+ * @param reentrant     allow simultaneous calls from several threads
+ */
+void calc_getelec(struct emission &gt, const bool space_charge, const bool reentrant);
+
 /** Class to calculate field emission effects with GETELEC */
 class EmissionReader: public FileWriter {
 public:
@@ -100,14 +115,61 @@ public:
         }
     } stats;
 
+    /** Usage statistics of the cache of GETELEC results */
+    struct CacheStats {
+        int n_hits = 0;         ///< # faces whose emission was reused during last calculation
+        int n_misses = 0;       ///< # GETELEC calls during last calculation
+        int n_tabulated = 0;    ///< # faces whose emission was interpolated from table during last calculation
+        long total_hits = 0;    ///< # reused face emissions since the start
+        long total_misses = 0;  ///< # GETELEC calls since the start
+
+        friend ostream& operator <<(ostream &stream, const CacheStats &c) {
+            stream << "Emission cache hits=" << c.n_hits << ", misses=" << c.n_misses
+                    << ", tabulated=" << c.n_tabulated
+                    << ", total hits=" << c.total_hits << ", total misses=" << c.total_misses;
+            return stream;
+        }
+    } cache_stats;
+
 private:
+    /** GETELEC input and output of a face from the previous calculation */
+    struct CachedEmission {
+        double F = 0;       ///< local field [V/nm]
+        double T = 0;       ///< temperature [K]
+        double V = 0;       ///< potential at the end of the line; 0 if line was not used
+        double Veff = 0;    ///< effective applied voltage
+        double J = 0;       ///< current density [amps/A^2]
+        double heat = 0;    ///< nottingham heat [W/A^2]
+        double theta = 1;   ///< space charge reduction factor
+        int marker = -1;    ///< calculation method, as in markers; -1 marks missing data
+    };
+
     /** Prepares the line inputed to GETELEC.
      *
+     * @param line       interpolator of the potential on the line
+     * @param rline      line distance from the starting point
+     * @param Vline      potential on the line
      * @param point      Starting point of the line
      * @param direction  Direction of the line
      * @param rmax       Maximum distance that the line extends
      */
-    void emission_line(const Point3& point, const Vec3& direction, const double rmax);
+    void emission_line(FieldReader &line, vector<double> &rline, vector<double> &Vline,
+            const Point3& point, const Vec3& direction, const double rmax) const;
+
+    /** Prepares the GETELEC input for the face.
+     * The line is calculated and attached only if the local field exceeds the given threshold.
+     * @return true if the line was used, false otherwise
+     */
+    bool face_emission_input(struct emission &gt, FieldReader &line, vector<double> &rline,
+            vector<double> &Vline, const int face, const double Fmin_line, const bool blunt) const;
+
+    /** Check whether the previous emission of the face can be reused for the current GETELEC input */
+    bool cache_hit(const CachedEmission &cached, const struct emission &gt, const double V,
+            const double Veff, const Config::Emission &conf) const;
+
+    /** Store the GETELEC input and output of the face */
+    void cache_store(CachedEmission &cached, const struct emission &gt, const double V,
+            const double Veff, const int marker) const;
 
     /** Calculates all the global values */
     void calculate_globals();
@@ -142,16 +204,16 @@ private:
     const HeatReader *heat;         ///< temperature on centroids of hexahedral faces.
     const TetgenMesh *mesh;         ///< data & operations about the mesh.
 
-    FieldReader phis_on_line;   ///< interpolated potential values on line
+    FieldReader phis_on_line;   ///< template of the interpolator of potential on line; copied for every thread
 
     vector<double> current_densities;    ///< emitted current densities on the interface faces [Amps/A^2]
     vector<double> nottingham;  ///< nottingham heat deposition on the interface faces [W/A^2]
     vector<double> currents;    ///< Current flux for every face (current_densities * face_areas) [Amps]
     vector<bool> is_effective;  ///< effective emission area
-    vector<double> rline;       ///< Line distance from the face centroid (passed into GETELEC)
-    vector<double> Vline;       ///< Potential on the straight line (complements rline)
     vector<double> thetas_SC;   ///< local field reduction factor due to SC
     vector<int> markers;        ///< debug data about how was emission calculated on given face
+    vector<CachedEmission> cache;   ///< GETELEC results of the previous calculation
+    EmissionTable table;            ///< tabulated emission for the faces with low current
 
     friend class Pic<3>;   // for convenience, allow Pic-class to access private data
 };
@@ -0,0 +1,93 @@
+/*
+ * EmissionTable.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef EMISSIONTABLE_H_
+#define EMISSIONTABLE_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+namespace femocs {
+
+/** @brief Surrogate of GETELEC that interpolates tabulated current density and Nottingham heat.
+ * The values are calculated with full energy integration in the nodes of uniform grid
+ * over the logarithm of field, temperature and logarithm of barrier radius.
+ * The error of trilinear interpolation in every cell is estimated from the second differences
+ * of the logarithm of current density, so the points with too big estimated error can be
+ * calculated directly with GETELEC. As building the table is expensive,
+ * it is stored in a binary file for every work function.
+ */
+class EmissionTable {
+public:
+    EmissionTable() {}
+
+    /** Make the table ready for the work function.
+     * The table is read from file, if it exists and corresponds to the table parameters;
+     * otherwise the table is calculated and written to file.
+     * @param work_function  work function [eV]
+     * @param file_base      path to the file without work function and extension
+     * @param reentrant      GETELEC may be called from several threads at once
+     */
+    void prepare(const double work_function, const string &file_base, const bool reentrant);
+
+    /** Interpolate the current density [A/nm^2] and Nottingham heat [W/nm^2]
+     * @param F      local field [V/nm]
+     * @param T      temperature [K]
+     * @param R      barrier radius [nm]
+     * @param tol    max estimated relative error of current density
+     * @return true if the point is inside the table and the estimated error is within tolerance
+     */
+    bool interpolate(double &J, double &heat, const double F, const double T, const double R, const double tol) const;
+
+    /** Estimate the radius of the barrier from the potential on the line that starts from the surface.
+     * Potential above the sphere with radius R is V(r) = F * R * r / (R + r).
+     * @param F      field on the surface [V/nm]
+     * @param rline  distance from the surface [nm]
+     * @param Vline  potential on the line [V]
+     */
+    static double barrier_radius(const double F, const vector<double> &rline, const vector<double> &Vline);
+
+    /** Return true if the table is not ready to be used */
+    bool empty() const { return log_J.size() == 0; }
+
+private:
+    static constexpr int nF = 64;          ///< # grid points in field
+    static constexpr int nT = 32;          ///< # grid points in temperature
+    static constexpr int nR = 12;          ///< # grid points in barrier radius
+    static constexpr double Fmin = 1.0;    ///< min field [V/nm]
+    static constexpr double Fmax = 15.0;   ///< max field [V/nm]
+    static constexpr double Tmin = 200.0;  ///< min temperature [K]
+    static constexpr double Tmax = 3000.0; ///< max temperature [K]
+    static constexpr double Rmin = 1.0;    ///< min barrier radius [nm]
+    static constexpr double Rmax = 1000.0; ///< max barrier radius [nm]
+    static constexpr double J_floor = 1e-200;  ///< min current density, that avoids log(0)
+
+    double work_function = -1;    ///< work function of the table [eV]
+    vector<double> log_J;         ///< logarithm of current density in grid nodes
+    vector<double> heat;          ///< Nottingham heat in grid nodes
+    vector<double> error;         ///< estimated error of interpolated log_J in grid cells
+
+    /** Return the index of the grid node */
+    int node(const int i, const int j, const int k) const { return (i * nT + j) * nR + k; }
+
+    /** Calculate the table values with GETELEC */
+    void calculate(const bool reentrant);
+
+    /** Estimate the interpolation error in every cell */
+    void calc_errors();
+
+    /** Write table into binary file */
+    void write(const string &file_name) const;
+
+    /** Read table from binary file
+     * @return true if the file exists and has the same table parameters */
+    bool read(const string &file_name);
+};
+
+} // namespace femocs
+
+#endif /* EMISSIONTABLE_H_ */
@@ -59,6 +59,19 @@ public:
     void extract_solution(PoissonSolver<3>& fem, const bool smoothen);
     void extract_solution_old(PoissonSolver<3>& fem, const bool smoothen);
 
+    /** Store the current nodal solution as a basis for linear superposition */
+    void append_basis() { basis.push_back(*nodes.get_solutions()); }
+
+    /** Replace the nodal solution with the linear combination of stored bases.
+     * The nodes outside the FEM mesh keep their empty value. */
+    void superpose_basis(const vector<double> &coefficients);
+
+    /** Forget the stored bases */
+    void clear_basis() { basis.clear(); }
+
+    /** Return the number of stored bases */
+    int get_n_basis() const { return basis.size(); }
+
     InterpolatorNodes nodes;     ///< vertices and solutions on them
     LinearTetrahedra lintet;     ///< data & operations for linear tetrahedral interpolation
     LinearTriangles lintri;      ///< data & operations for linear triangular interpolation
@@ -71,6 +84,7 @@ private:
     const TetgenMesh* mesh;         ///< Full mesh data with nodes, faces, elements etc
     double empty_value;             ///< Solution value for nodes outside the Deal.II mesh
     vector<vector<pair<int,int>>> node2cells;  ///< list of hexahedra that are associated with given node
+    vector<vector<Solution>> basis; ///< nodal solutions whose linear combination gives the solution
 
     /** Transfer full solution from FEM solver to Interpolator */
     void store_solution(const vector<dealii::Tensor<1, 3>> &vecs,
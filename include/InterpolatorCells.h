@@ -201,6 +201,14 @@ public:
     /** Interpolate solution in the centroid of a cell */
     Solution interp_centroid(const int cell) const;
 
+    /** Obtain the nodes and their weights, that interp_solution uses to interpolate in the point.
+     * Makes it possible to store the interpolation as a sparse matrix. */
+    virtual void interp_weights(vector<int> &node_indices, vector<double> &weights,
+            const Point3 &point, const int cell) const;
+
+    /** Obtain the nodes and their weights, that interp_centroid uses to interpolate in the cell centroid */
+    void centroid_weights(vector<int> &node_indices, vector<double> &weights, const int cell) const;
+
     /** Interpolate minus gradient of solution for any point inside a given cell
      * @param point  point where the interpolation is performed
      * @param cell   index of cell around which the interpolation is performed */
@@ -320,7 +328,16 @@ public:
     /** Specify the region where the cells are searched during the cell location. */
     void narrow_search_to(const int region);
 
+    /** Find the tetrahedron that surrounds the point by walking along the face neighbours
+     * towards the point, starting from the guessed cell.
+     * If the walk fails, the cells overlapping with the point in the search grid are checked.
+     * @param n_slow  incremented if the walk did not succeed and the search grid was used
+     * @return        index of the cell surrounding the point; -1 if no such cell was found */
+    int walk_to_cell(const Point3 &point, const int cell_guess, int &n_slow) const;
+
 private:
+    static constexpr int n_walk_steps = 50;  ///< max # steps during the walk through the mesh
+
     const TetgenElements* tets;    ///< pointer to tetrahedra to access their specific routines
 
     vector<double> det0;            ///< major determinant for calculating bcc-s
@@ -329,12 +346,31 @@ private:
     vector<Vec4> det3;              ///< minor determinants for calculating 3rd bcc
     vector<Vec4> det4;              ///< minor determinants for calculating 4th bcc
     vector<bool> tet_not_valid;     ///< co-planarities of tetrahedra
+    vector<array<int,4>> face_neighbours;  ///< tetrahedra opposite to the nodes of tetrahedron; -1 if none
+
+    /** Uniform grid of buckets, each of which lists the searchable tetrahedra
+     * whose bounding box overlaps with the bucket */
+    struct SearchGrid {
+        Point3 origin;          ///< lower corner of the grid
+        double step = 1.0;      ///< edge length of the bucket
+        array<int,3> size;      ///< # buckets in x,y,z-direction
+        vector<int> starts;     ///< index of the first tetrahedron of i-th bucket in cells
+        vector<int> cells;      ///< tetrahedra sorted by the buckets
+    } grid;
 
     /** Reserve memory for pre-compute data */
     void reserve(const int N);
 
     /** Return the tetrahedron type in vtk format */
     int get_cell_type() const { return VtkType::tetrahedron; }
+
+    /** Distribute the searchable tetrahedra between the buckets of search grid */
+    void build_search_grid();
+
+    /** Index of the search grid bucket in given direction */
+    int get_bucket(const double coord, const double origin, const int size) const {
+        return max(0, min(size - 1, int((coord - origin) / grid.step)));
+    }
 };
 
 /**
@@ -415,6 +451,12 @@ public:
     /** Find the hexahedron which contains the point or is the closest to it */
     int locate_cell(const Point3 &point, const int cell_guess) const;
 
+    /** Find the hexahedron which contains the point by walking through the mesh,
+     * starting from the guessed cell. Suitable for following moving particles.
+     * @param n_slow  incremented if the walk did not succeed and the slower search was used
+     * @return        index of the surrounding hexahedron; -1 if point is outside the mesh */
+    int walk_to_cell(const Point3 &point, const int cell_guess, int &n_slow) const;
+
     /** Get interpolation weights for a point inside i-th hexahedron */
     array<double,8> shape_functions(const Vec3& point, const int i) const;
 
@@ -514,6 +556,10 @@ public:
      * Search starts from tetrahedra that are connected to the given triangle. */
     Solution interp_solution(const Point3 &point, const int tri) const;
 
+    /** Obtain the tetrahedral nodes and weights, that interp_solution uses */
+    void interp_weights(vector<int> &node_indices, vector<double> &weights,
+            const Point3 &point, const int tri) const;
+
     /** Interpolate conserved scalar data for the vector of atoms */
     void interp_conserved(vector<double>& scalars, const vector<Atom>& atoms) const;
 
@@ -558,6 +604,9 @@ private:
     /** Return the triangle type in vtk format */
     int get_cell_type() const { return VtkType::triangle; };
 
+    /** Find the tetrahedron, that surrounds the point near the triangle */
+    int locate_tet(const Point3 &point, const int tri) const;
+
     /** Return the distance between a point and i-th triangle in the direction of its norm.
      * If the projection of the point is outside the triangle, the 1e100 distance will be returned.
      * The calculations are based on Moller-Trumbore algorithm. The theory about it can be found from
@@ -597,6 +646,10 @@ public:
      * Search starts from tetrahedra that are connected to the given triangle. */
     Solution interp_solution(const Point3 &point, const int tri) const;
 
+    /** Obtain the tetrahedral nodes and weights, that interp_solution uses */
+    void interp_weights(vector<int> &node_indices, vector<double> &weights,
+            const Point3 &point, const int tri) const;
+
     /** Return i-th hexahedron */
     SimpleCell<6> get_cell(const int i) const {
         require(i >= 0 && i < (int)cells.size(), "Invalid index: " + d2s(i));
@@ -623,6 +676,9 @@ private:
 
     /** Calculate the vertex indices of 6-noded triangle */
     SimpleCell<6> calc_cell(const int i) const;
+
+    /** Find the tetrahedron, that surrounds the point near the triangle */
+    int locate_tet(const Point3 &point, const int tri) const;
 };
 
 /**
@@ -648,6 +704,10 @@ public:
      * Search starts from hexahedra that are connected to the given quadrangle. */
     Solution interp_solution(const Point3 &point, const int quad) const;
 
+    /** Obtain the hexahedral nodes and weights, that interp_solution uses */
+    void interp_weights(vector<int> &node_indices, vector<double> &weights,
+            const Point3 &point, const int quad) const;
+
     /** Return i-th quadrangle */
     SimpleCell<4> get_cell(const int i) const { return (*quads)[i]; }
 
@@ -667,6 +727,9 @@ private:
 
     /** Return the quadrangle type in vtk format */
     int get_cell_type() const { return VtkType::quadrangle; };
+
+    /** Find the hexahedron, that surrounds the point near the quadrangle */
+    int locate_hex(const Point3 &point, const int quad) const;
 };
 
 } /* namespace femocs */
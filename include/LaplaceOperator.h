@@ -0,0 +1,88 @@
+/*
+ * LaplaceOperator.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef LAPLACEOPERATOR_H_
+#define LAPLACEOPERATOR_H_
+
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <map>
+
+using namespace dealii;
+using namespace std;
+
+namespace femocs {
+
+/** @brief Matrix-free operator of Laplace equation on linear hexahedral mesh.
+ * Instead of storing the global sparse matrix, only the geometric data of the cells is precomputed
+ * and the action of the matrix is evaluated cell by cell, processing several cells at once with SIMD instructions.
+ * The rows of the Dirichlet dofs act as identity, so the operator is symmetric positive definite
+ * and can be used with CG and Chebyshev-Jacobi preconditioner.
+ */
+template<int dim>
+class LaplaceOperator : public Subscriptor {
+public:
+    static constexpr int fe_degree = 1;  ///< degree of the shape functions
+
+    LaplaceOperator() {}
+
+    /** Precompute the cell data and the diagonal of the operator
+     * @param dof_handler      dofs of the mesh
+     * @param boundary_values  Dirichlet dofs and their values
+     */
+    void initialize(const DoFHandler<dim> &dof_handler, const map<types::global_dof_index, double> &boundary_values);
+
+    /** Release the cell data */
+    void clear();
+
+    /** Number of rows of the operator */
+    unsigned int m() const { return inv_diag.size(); }
+
+    /** Number of columns of the operator */
+    unsigned int n() const { return inv_diag.size(); }
+
+    /** Diagonal element of the operator; only diagonal can be accessed */
+    double el(const unsigned int i, const unsigned int j) const;
+
+    /** Calculate dst = A * src */
+    void vmult(Vector<double> &dst, const Vector<double> &src) const;
+
+    /** Calculate dst = A^T * src = A * src */
+    void Tvmult(Vector<double> &dst, const Vector<double> &src) const { vmult(dst, src); }
+
+    /** Move the contribution of the Dirichlet values to the right-hand-side vector,
+     * i.e calculate rhs -= A * g for free dofs and set rhs = 0 for Dirichlet dofs,
+     * where g contains the Dirichlet values and zeros elsewhere. */
+    void apply_lifting(Vector<double> &rhs, const map<types::global_dof_index, double> &boundary_values) const;
+
+    /** Inverse of the diagonal of the operator */
+    const Vector<double>& get_inv_diag() const { return inv_diag; }
+
+private:
+    MatrixFree<dim, double> data;     ///< geometric data of the cells
+    ConstraintMatrix constraints;     ///< homogeneous constraints on Dirichlet dofs
+    Vector<double> inv_diag;          ///< inverse of the diagonal of the operator
+
+    /** Apply the operator on a range of cells; constrained dofs in src are treated as zero */
+    void local_apply(const MatrixFree<dim, double> &data, Vector<double> &dst,
+            const Vector<double> &src, const pair<unsigned int, unsigned int> &cell_range) const;
+
+    /** Apply the operator on a range of cells without resolving the constraints in src */
+    void local_apply_plain(const MatrixFree<dim, double> &data, Vector<double> &dst,
+            const Vector<double> &src, const pair<unsigned int, unsigned int> &cell_range) const;
+
+    /** Calculate the diagonal of the operator on a range of cells */
+    void local_diagonal(const MatrixFree<dim, double> &data, Vector<double> &dst,
+            const unsigned int &dummy, const pair<unsigned int, unsigned int> &cell_range) const;
+};
+
+} // namespace femocs
+
+#endif /* LAPLACEOPERATOR_H_ */
@@ -13,29 +13,55 @@
 
 namespace femocs {
 
-/** Super particles for PIC simulation */
+/** Super particles for PIC simulation.
+ * The data is stored in structure-of-arrays format, i.e positions, velocities, cells and weights
+ * are in separate contiguous arrays. To improve the data locality, particles can be
+ * sorted by the Deal.II index of the cell they belong to. */
 class ParticleSpecies {
 public:
     ParticleSpecies(double q_over_m, double q_over_eps0, double Wsp);
     ~ParticleSpecies() {};
 
     void reserve(const int n_particles) {
-        parts.reserve(n_particles);
+        pos.reserve(n_particles);
+        vel.reserve(n_particles);
+        cell.reserve(n_particles);
+        weight.reserve(n_particles);
     }
 
-    void inject_particle(const Point3 &pos, const Vec3 &vel, const int cell) {
-        parts.push_back(SuperParticle(pos, vel, cell));
+    /** Change the nr of SP-s; new SP-s must be initialized afterwards */
+    void resize(const int n_particles) {
+        pos.resize(n_particles);
+        vel.resize(n_particles);
+        cell.resize(n_particles);
+        weight.resize(n_particles, 1.0);
+    }
+
+    void inject_particle(const Point3 &p, const Vec3 &v, const int c, const double w=1.0) {
+        pos.push_back(p);
+        vel.push_back(v);
+        cell.push_back(c);
+        weight.push_back(w);
     }
 
     void inject_particle(const SuperParticle &sp) {
-        parts.push_back(sp);
+        inject_particle(sp.pos, sp.vel, sp.cell);
     }
 
-    void clear() { parts.clear(); }
+    void clear() {
+        pos.clear();
+        vel.clear();
+        cell.clear();
+        weight.clear();
+    }
 
     int clear_lost();
 
-    int size() const { return parts.size(); }
+    /** Sort particles by their cell index so that the particles in the same cell
+     * are located next to each other in memory. Ordering within the cell is preserved. */
+    void sort(const int n_cells);
+
+    int size() const { return cell.size(); }
 
     double get_Wsp() const { return Wsp; }
 
@@ -44,30 +70,26 @@ public:
         this->Wsp = Wsp;
     }
 
-    /** Accessor for accessing the i-th SP */
-    const SuperParticle& operator [](const size_t i) const {
-        require(i < size(), "Invalid index: " + d2s(i));
-        return parts[i];
-    }
-    SuperParticle& operator [](const size_t i) {
-        require(i < size(), "Invalid index: " + d2s(i));
-        return parts[i];
-    }
+    /** Change the SP weight and rescale the relative weights of the SP-s
+     * so that the total charge of the system remains the same */
+    void rescale_Wsp(double Wsp);
 
-    /** Iterator to access the particles */
-    typedef vector<SuperParticle>::iterator iterator;
-    typedef vector<SuperParticle>::const_iterator const_iterator;
-    iterator begin() { return parts.begin(); }
-    iterator end() { return parts.end(); }
-    const_iterator begin() const { return parts.begin(); }
-    const_iterator end() const { return parts.end(); }
+    /** Return copy of the data about the i-th SP */
+    SuperParticle get_particle(const int i) const {
+        require(i >= 0 && i < size(), "Invalid index: " + d2s(i));
+        return SuperParticle(pos[i], vel[i], cell[i]);
+    }
 
     const double q_over_m;      ///< SP charge / its mass [A^2 / (V fs^2)]
     const double q_over_eps0;   ///< (whole) particle charge / eps0 [e/VÅ]
 
+    vector<Point3> pos;         ///< particle positions [Å]
+    vector<Vec3> vel;           ///< particle velocities [Å/fs]
+    vector<int> cell;           ///< Deal.II hexahedron IDs, -1 if particle is outside the domain
+    vector<double> weight;      ///< particle weights relative to Wsp
+
 private:
     double Wsp;                 ///< SP weight [particles/superparticle]
-    vector<SuperParticle> parts;
 };
 
 } // namespace femocs
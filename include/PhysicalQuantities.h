@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <algorithm>
 #include "Config.h"
 
 namespace femocs {
@@ -92,6 +93,18 @@ public:
      */
     double dkappa(double temperature) const;
 
+    /** Evaluate electrical conductivity in all the temperatures, e.g in quadrature points of a cell */
+    void sigma(const std::vector<double> &temperatures, std::vector<double> &values) const;
+
+    /** Evaluate electrical conductivity derivative in all the temperatures */
+    void dsigma(const std::vector<double> &temperatures, std::vector<double> &values) const;
+
+    /** Evaluate thermal conductivity in all the temperatures */
+    void kappa(const std::vector<double> &temperatures, std::vector<double> &values) const;
+
+    /** Evaluate thermal conductivity derivative in all the temperatures */
+    void dkappa(const std::vector<double> &temperatures, std::vector<double> &values) const;
+
     /**
      * Outputs sigma, kappa, res (and d-s) and emission currents to files in specified path
      * NB: Slow!!!
@@ -121,19 +134,60 @@ private:
 
     std::vector<std::pair<double, double> > resistivity_data;
 
+    /**
+     * Resistivity and conductivities tabulated on uniform temperature grid.
+     * Values between the grid points are found with linear interpolation,
+     * so the location of the temperature is found without searching.
+     */
+    struct LookupTable {
+        std::vector<double> rho, drho;       ///< resistivity and its derivative
+        std::vector<double> sigma, dsigma;   ///< electrical conductivity and its derivative
+        std::vector<double> kappa, dkappa;   ///< thermal conductivity and its derivative
+        double tmin = 0, tmax = 0;           ///< temperature range of the table
+        double inv_step = 0;                 ///< inverse of the temperature step
+    };
+    LookupTable table;
+
+    /** Min # grid points in lookup table */
+    static constexpr int n_table_min = 4096;
+
+    /** Tabulate resistivity, conductivities and their derivatives from resistivity data */
+    void build_lookup_table();
+
+    /** Obtain the table interval and the position of temperature in it */
+    inline int table_index(double temperature, double &weight) const {
+        if (temperature <= table.tmin) { weight = 0; return 0; }
+        if (temperature >= table.tmax) { weight = 1; return table.rho.size() - 2; }
+        const double x = (temperature - table.tmin) * table.inv_step;
+        const int i = std::min(int(x), int(table.rho.size()) - 2);
+        weight = x - i;
+        return i;
+    }
+
+    /** Interpolate the tabulated values linearly */
+    inline double table_value(const std::vector<double> &values, double temperature) const {
+        double w;
+        const int i = table_index(temperature, w);
+        return values[i] + w * (values[i+1] - values[i]);
+    }
+
+    /** Interpolate the tabulated values in all the temperatures */
+    void table_values(const std::vector<double> &values, const std::vector<double> &temperatures,
+            std::vector<double> &result) const;
+
     /**
      * 1d linear interpolation with constant extrapolation using binary search
      */
-    double linear_interp(double x, std::vector<std::pair<double, double>> data) const;
+    double linear_interp(double x, const std::vector<std::pair<double, double>> &data) const;
 
     /**
      * 1d linear interpolation of the derivative with constant extrapolation using binary search
      * derivative is approximated with central differences (one sided at ends)
      */
-    double deriv_linear_interp(double x, std::vector<std::pair<double, double>> data) const;
+    double deriv_linear_interp(double x, const std::vector<std::pair<double, double>> &data) const;
 
-    double evaluate_derivative(std::vector<std::pair<double, double>> &data,
-            std::vector<std::pair<double, double>>::iterator it) const;
+    double evaluate_derivative(const std::vector<std::pair<double, double>> &data,
+            std::vector<std::pair<double, double>>::const_iterator it) const;
 
     /**
      * 2d bilinear interpolation with constant extrapolation
@@ -20,9 +20,40 @@
 #include "FileWriter.h"
 
 #include <random>
+#include <cstdint>
 
 namespace femocs {
 
+/** Counter-based pseudo-random number engine.
+ * The i-th output is a SplitMix64 hash of the key and i, so that independent and reproducible
+ * streams can be cheaply created for any combination of seed, timestep and cell or face index.
+ * Satisfies the requirements of UniformRandomBitGenerator and can be used with std distributions. */
+class RandomStream {
+public:
+    typedef uint64_t result_type;
+
+    RandomStream(const uint64_t seed, const uint64_t step, const uint64_t id) :
+        key(hash(hash(hash(seed) ^ step) ^ id)), counter(0) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    /** Generate next random number in the stream */
+    result_type operator()() { return hash(key + golden_gamma * (++counter)); }
+
+private:
+    static constexpr uint64_t golden_gamma = 0x9E3779B97F4A7C15ULL;
+    uint64_t key;       ///< unique identifier of the stream
+    uint64_t counter;   ///< nr of generated numbers
+
+    /** SplitMix64 finalizer */
+    static uint64_t hash(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
 /** Class for running PIC (particle-in-cell) simulations to solve Poisson equation.
  * For further details about PIC, see Kyrre Ness Sjøbæk PhD thesis at
  * https://cds.cern.ch/record/2226840
@@ -40,22 +71,49 @@ public:
     /** e-e or i-i Coulomb collision routine (for the same type of particles) */
     void collide_particles();
 
-    /** Update the positions of the particles and the cell they belong. */
-    int update_positions();
+    /** Keep the nr of SP-s in each cell close to the target value by merging the SP-s
+     * in over-populated cells and splitting them in sparse ones.
+     * @return change in the nr of SP-s */
+    int control_population();
 
-    /** Update the velocities on the particles using the fields calculated at the given positions */
-    void update_velocities();
+    /** Update the velocities of the particles using the fields calculated at their positions,
+     * then update their positions and the cells they belong to.
+     * Kick, drift and cell update are performed in a single pass over the particles.
+     * @return nr of particles that left the domain */
+    int push_particles();
+
+    /** Find the cells of the particles without moving them, e.g after the mesh has changed.
+     * @return nr of particles that were not located in the mesh */
+    int update_cells();
 
     /** Read particle data from file */
     void read(const string &filename);
     
     /** Store various data */
     void set_params(const double dt, const TetgenNodes::Stat box) {
-        electrons.set_Wsp(conf->weight_el);
+        // with population control, changing the SP weight must not change the total charge
+        if (conf->particles_per_cell > 0)
+            electrons.rescale_Wsp(conf->weight_el);
+        else
+            electrons.set_Wsp(conf->weight_el);
         data.dt = dt;
         data.box = box;
     }
 
+    /** Calculate the total charge of SP-s in the units of SP weight and the centre of the charge */
+    double calc_charge(Point3 &center) const;
+
+    /** Change the timestep */
+    void set_dt(const double dt) { data.dt = dt; }
+
+    /** Calculate the max distance, that SP-s travelled during last push, in the units of their cell size */
+    double calc_max_shift() const;
+
+    /** Calculate the max timestep, during which no SP travels more than the courant fraction of its cell size
+     * and which resolves the local plasma oscillations; the result is limited by dt_max.
+     * @param limiter  name of the criterion that determined the timestep */
+    double calc_max_dt(string &limiter) const;
+
     /** Return pointer to charged super-particles */
     ParticleSpecies* get_particles() { return &electrons; }
 
@@ -73,6 +131,7 @@ public:
     void reinit() {
         stats_reinit();
         electrons.clear();
+        data.dt_prev = 0;
     }
 
     /** Return # electron super particles that were injected during last push */
@@ -81,6 +140,9 @@ public:
     /** Return # electron super particles that were deleted during last clean */
     int get_removed() const { return data.removed; }
 
+    /** Return # electron super particles during last push, whose cell was located via slow path */
+    int get_n_slow_locates() const { return data.n_slow_locates; }
+
     /**  Check if the # injected particles is roughly equal to the # removed */
     bool is_stable() const {
         return abs(data.injected - data.removed) / data.injected < 0.1 ;
@@ -91,23 +153,33 @@ private:
     static constexpr double e_over_eps0 = 180.9512268;    ///< electron charge / vacuum permittivity [V*Angstrom]
     static constexpr double electrons_per_fs = 6.2415e3;  ///< definition of 1 ampere
     static constexpr double twopi = 6.2831853071795864;   ///< 2 * pi
+    static constexpr double min_split_weight = 1.0 / 64;  ///< min relative weight of SP that is still allowed to be split
+    static constexpr double plasma_factor = 0.2;          ///< max product of plasma frequency and adaptive timestep
 
     const PoissonSolver<dim> *poisson_solver; ///< object to solve Poisson equation in the vacuum mesh
     const EmissionReader *emission;           ///< object to obtain the field emission data
     const Interpolator *interpolator;         ///< data & operation for interpolating in vacuum
     const Config::PIC *conf;                  ///< PIC configuration parameters
+    const unsigned int seed;                  ///< seed for the random number generators
 
     ParticleSpecies electrons;    ///< Electron super particles carrying charge density in space
 
     struct Data {
         TetgenNodes::Stat box;    ///< simubox size data
         double dt = 0;            ///< timestep [fs]
+        double dt_prev = 0;       ///< timestep of the previous push [fs]; 0 if there was none
         int injected = 0;
         int removed = 0;
+        int n_pushes = 0;         ///< nr of position updates since the beginning
+        int n_slow_locates = 0;   ///< nr of SP-s during last push whose cell was not found by walking
     } data;
 
-    mt19937 mersenne;     ///< Mersenne twister pseudo-random number engine
-    uniform_real_distribution<double> uniform{0.0, 1.0};  ///< Random nr generator that maps Mersenne twister output uniformly into range [0.0 1.0] (both inclusive)
+    /** Return the key of random streams for the current PIC step.
+     * The tag separates the streams of different operations within the same step. */
+    uint64_t get_stream_step(const uint64_t tag) const;
+
+    /** Return the timestep of the previous push or the current one if there was none */
+    double get_dt_prev() const { return data.dt_prev > 0 ? data.dt_prev : data.dt; }
 
     /** Clear all particles out of the box */
     void clear_lost_particles();
@@ -115,24 +187,37 @@ private:
     /** Computes the charge density for each FEM DOF */
     void compute_field(bool first_time = false, bool write_time = false);
 
-    /** Inject electron super particles at the surface faces, depending on the current and the timestep */
-    void inject_electrons(vector<Point3> &pos, vector<int> &cells, const TetgenMesh &mesh);
+    /** Calculate the nr of electron super particles injected from the surface face,
+     * depending on the current and the timestep */
+    int get_n_injected(const int face, RandomStream &rng) const;
 
     /** Generate point with an uniform distribution inside a quadrangle */
-    Point3 get_rnd_point(const int quad, const TetgenMesh &mesh);
+    Point3 get_rnd_point(const int quad, const TetgenMesh &mesh, RandomStream &rng) const;
 
     /** Update position and cell index of a super particle with given index */
-    void update_position(const int particle_index);
+    void update_position(const int particle_index, int &n_slow);
 
     /** Find the hexahedron where the point is located.
-     * Both input and output hex indices are Deal.II ones. */
-    int update_point_cell(const SuperParticle& particle) const;
+     * Both input and output hex indices are Deal.II ones.
+     * n_slow is incremented if the fast walk through the mesh was not successful. */
+    int update_point_cell(const Point3 &pos, const int cell, int &n_slow) const;
 
-    /** Group SP-s by the common cells and shuffle their ordering before performing Coulomb collision */
-    void group_and_shuffle_particles(vector<vector<size_t>> &particles_in_cell);
+    /** Group SP-s by the common cells.
+     * Indices of the SP-s in i-th cell are stored in particles[cell_starts[i] : cell_starts[i+1]] */
+    void group_particles(vector<int> &particles, vector<int> &cell_starts) const;
 
     /** Perform binary collision between two charged particles of the same kind */
-    void collide_pair(int p1, int p2, double variance);
+    void collide_pair(int p1, int p2, double variance, RandomStream &rng);
+
+    /** Merge groups of SP-s with similar velocities, each into two SP-s,
+     * so that the charge, momentum and kinetic energy of the group are conserved.
+     * Merged-away SP-s are marked with cell -1. */
+    void merge_particles(int* parts, const int n_parts, const int group_size);
+
+    /** Split the heaviest SP-s into two halves with the same velocity.
+     * The displacements of the halves are stored into splits to create the copies later. */
+    void split_particles(int* parts, const int n_parts, const int n_new, const int cell,
+            RandomStream &rng, vector<pair<int,Vec3>> &splits);
 
     /** Specify file types that can be written */
     bool valid_extension(const string &ext) const {
@@ -9,6 +9,7 @@
 #define LAPLACE_H_
 
 #include "DealSolver.h"
+#include "LaplaceOperator.h"
 #include "Config.h"
 #include "InterpolatorCells.h"
 #include "ParticleSpecies.h"
@@ -51,13 +52,38 @@ public:
     void export_charge_dens(vector<double> &charge_dens) const;
 
     /** Run Conjugate-Gradient solver to solve matrix equation */
-    int solve() { return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param); }
+    int solve();
+
+    /** Solve Laplace equation for unit applied field (Neumann anode BC) or unit applied potential (Dirichlet anode BC)
+     * and store the result as the basis for superposition. Afterwards the solution corresponds
+     * to the field and potential given in setup(). setup() must be called beforehand. */
+    int calc_laplace_basis();
+
+    /** Replace the solution with the superposition of stored Laplace solutions
+     * that corresponds to given applied field and potential. Doesn't require solving. */
+    void superpose_laplace_basis(const double field, const double potential);
+
+    /** Check whether Laplace basis solutions are available for current mesh */
+    bool has_laplace_basis() const {
+        return laplace_basis.field.size() > 0 && laplace_basis.field.size() == this->solution.size();
+    }
+
+    /** Forget Laplace basis solutions; must be called whenever the mesh changes */
+    void clear_laplace_basis() {
+        laplace_basis.field.reinit(0);
+        laplace_basis.potential.reinit(0);
+    }
+
+    /** Check whether the solution depends linearly on applied field and potential, i.e there's no space charge */
+    bool is_linear() const { return conf->mode == "laplace" || !particles || particles->size() == 0; }
 
     /** Setup system for solving Poisson equation */
     void setup(const double field, const double potential);
 
     /** Assemble the matrix equation to solve Laplace or Poisson equation
-     * by appling Neumann BC (constant field) or Dirichlet BC (constant potential) on top of simubox */
+     * by appling Neumann BC (constant field) or Dirichlet BC (constant potential) on top of simubox.
+     * If not full run, system matrix and BCs from the last full run are reused and only the space charge is added.
+     * Full run is forced if applied field or potential has changed since the last full run. */
     void assemble(const bool first_time);
 
 private:
@@ -68,7 +94,20 @@ private:
     double applied_field;     ///< applied electric field on top of simubox
     double applied_potential; ///< applied potential on top of simubox
     Vector<double> charge_density;   ///< charge density at dofs [e/Angstrom^3]
-    SparseMatrix<double> system_matrix_save;  ///< system matrix before applying Dirichlet BCs
+    Vector<double> system_rhs_bc;    ///< rhs from the BCs after applying them to the system matrix
+    double bc_field;                 ///< applied field used to calculate system_rhs_bc
+    double bc_potential;             ///< applied potential used to calculate system_rhs_bc
+
+    /** Laplace solutions for unit applied field and unit applied potential */
+    struct LaplaceBasis {
+        Vector<double> field;
+        Vector<double> potential;
+    } laplace_basis;
+
+    static constexpr int chebyshev_degree = 4;          ///< degree of Chebyshev preconditioner in matrix-free mode
+    static constexpr double chebyshev_range = 30.0;     ///< ratio of max and min eigenvalue treated by Chebyshev preconditioner
+    LaplaceOperator<dim> laplace_operator;              ///< matrix-free system operator
+    PreconditionChebyshev<LaplaceOperator<dim>, Vector<double>> chebyshev;  ///< Chebyshev-Jacobi preconditioner for matrix-free mode
 
     typedef typename DealSolver<dim>::LinearSystem LinearSystem;
     typedef typename DealSolver<dim>::ScratchData ScratchData;
@@ -83,6 +122,9 @@ private:
     /** Write the electric potential and field to a file in vtk format */
     void write_vtk(ofstream& out) const;
 
+    /** Short name of the solver used in the solver log file */
+    string get_name() const { return "poisson"; }
+
     /** Mark different regions in mesh */
     void mark_mesh();
 
@@ -92,6 +134,12 @@ private:
     /** Assemble left-hand-side of matrix equation in a parallel manner */
     void assemble_parallel();
 
+    /** Initialize matrix-free operator and its preconditioner and move the Dirichlet BCs into rhs */
+    void setup_matrix_free();
+
+    /** Run Conjugate-Gradient solver with matrix-free operator */
+    int solve_matrix_free();
+
     /** Calculate the contribution of one cell into global matrix and rhs vector */
     void assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
             ScratchData &scratch_data, CopyData &copy_data) const;
@@ -99,9 +147,6 @@ private:
     /** Add to the right-hand-side vector for point charges, as used in PIC. */
     void assemble_space_charge();
     void assemble_space_charge_fast();
-
-    /** Restore system matrix to the shape it was before applying Dirichlet BCs */
-    void restore_system_matrix();
 };
 
 } // namespace femocs
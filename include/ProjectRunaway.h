@@ -76,6 +76,7 @@ protected:
     bool first_run;             ///< True only as long as there is no full run
     double last_heat_time;      ///< Last time heat was updated
     double last_pic_time;       ///< Last time PIC solver was called
+    double heat_dt;             ///< Heat time step proposed by adaptive time stepping [fs]
     int last_restart_ts;        ///< Last time step reset file was written
 
     Coarseners coarseners;      ///< atomistic coarsening data & routines
@@ -93,6 +94,7 @@ protected:
     FieldReader surface_fields;       ///< fields on surface hex face centroids
     HeatReader  surface_temperatures; ///< temperatures & current densities on surface hex face centroids
     HeatReader  heat_transfer;        ///< temperatures on new mesh dofs interpolated on old solution space
+    FieldReader field_transfer;       ///< potentials on new mesh dofs interpolated on old solution space
 
     PhysicalQuantities phys_quantities; ///< quantities used in heat calculations
     PoissonSolver<3> poisson_solver;    ///< Poisson equation solver
@@ -101,6 +103,15 @@ protected:
     EmissionReader emission;          ///< emission data on centroids of surface quadrangles
     Pic<3> pic_solver;                       ///< class for solving Poisson equation and handling space charge
 
+    /** Data for skipping the field solve in PIC steps, where space charge has changed negligibly */
+    struct FieldSubcycling {
+        double charge = 0;      ///< space charge during last field solve
+        Point3 center;          ///< centre of space charge during last field solve
+        double shift = 0;       ///< upper bound of SP displacement since last field solve in units of cell size
+        int n_frozen = 0;       ///< nr of PIC steps since last field solve
+        int n_skipped = 0;      ///< nr of skipped field solves during current PIC run
+    } subcycling;
+
     /** Generate bulk and vacuum meshes using the imported atomistic data */
     int generate_mesh();
 
@@ -108,6 +119,10 @@ protected:
      * and transfer temperature from previous iteration to the new mesh */
     int prepare_solvers();
 
+    /** Transfer the potential from the previous mesh to the new one
+     * to be used as the initial guess for the Poisson solver */
+    void transfer_potential();
+
     /** Calculate data of interest on the locations of imported atoms */
     int prepare_export();
 
@@ -120,6 +135,15 @@ protected:
     /** Solve transient heat and continuity equations */
     int solve_heat(double T_ambient, double delta_time, bool full_run, int& ccg, int& hcg);
 
+    /** Advance temperature for delta time with time steps that keep the local error
+     * of temperature within tolerance. Every step is made with both implicit Euler and
+     * Crank-Nicolson method and their difference is used as the error estimate.
+     * @param hcg  # CG iterations in last accepted step */
+    int advance_heat(double delta_time, int& hcg);
+
+    /** Solve stationary heat and continuity equations with Newton iterations */
+    int solve_steady_heat(bool full_run);
+
     /** Using the electric field, calculate atomistic charge together with Lorenz and/or Coulomb force */
     int solve_force();
 
@@ -156,6 +180,10 @@ private:
     /** Perform one iteration of PIC calculation */
     int make_pic_step(int& n_lost, int& n_cg, int& n_injected, bool full_run);
 
+    /** Determine whether space charge has changed enough since last PIC step with field solve
+     * to justify solving the field again */
+    bool need_field_solve(bool full_run);
+
     /** Perform one iteration of field emission calculation */
     int calc_heat_emission(bool full_run);
 
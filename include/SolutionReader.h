@@ -64,6 +64,23 @@ public:
         interp_centroids = _centroid;
         dim = _dim;
         rank = _rank;
+        interp_matrix.clear();
+    }
+
+    /** Enable or disable storing the interpolation weights as a sparse matrix.
+     * The matrix is built when the points are mapped to the cells
+     * and every later interpolation is the product of the matrix and nodal solutions.
+     * The points must not move while the matrix is in use. Doesn't work with sorting of atoms. */
+    void set_sparse_interpolation(const bool enable) {
+        sparse_interpolation = enable;
+        if (!enable) interp_matrix.clear();
+    }
+
+    /** Forget the cells of the points and the interpolation matrix.
+     * Must be called after the mesh has changed, as the mesh may keep the same nr of nodes. */
+    void reset_mapping() {
+        atoms_mapped_to_cells = false;
+        interp_matrix.clear();
     }
 
     /** Alter the pointer to interpolator */
@@ -114,6 +131,22 @@ protected:
 
     Interpolator* interpolator;    ///< pointer to interpolator
     vector<Solution> interpolation;       ///< interpolated data
+    bool sparse_interpolation;    ///< store the interpolation weights in sparse matrix
+
+    /** Interpolation weights in compressed row storage; i-th row maps the nodal solutions into i-th point */
+    struct InterpolationMatrix {
+        vector<int> starts;     ///< index of the first entry of every row; size is n_rows + 1
+        vector<int> cols;       ///< indices of the nodes
+        vector<double> vals;    ///< weights of the nodes
+        int n_cols = 0;         ///< # nodes at the time of building the matrix
+
+        bool empty() const { return starts.size() == 0; }
+
+        void clear() {
+            starts.clear(); cols.clear(); vals.clear();
+            n_cols = 0;
+        }
+    } interp_matrix;
 
     /** Initialise statistics about coordinates and solution */
     void init_statistics();
@@ -138,6 +171,15 @@ protected:
     /** Interpolate the solution for i-th centroidal point */
     void interp_centroid(const int i);
 
+    /** Obtain the nodes and weights, that are used to interpolate the solution for i-th point */
+    void interp_weights(const int i, vector<int> &node_indices, vector<double> &weights) const;
+
+    /** Store the interpolation weights of all the points into sparse matrix */
+    void calc_interp_matrix();
+
+    /** Interpolate the solution for all the points by multiplying nodal solutions with the sparse matrix */
+    void apply_interp_matrix();
+
     /** Sort atoms and interpolation by the atom ID */
     void restore_sorting();
 
@@ -174,6 +216,10 @@ public:
     /** In addition to regular interpolation, pre-calculate also field norms */
     void calc_interpolation();
 
+    /** Interpolate potential on the mesh DOFs of the FEM solver
+     * and use it as the initial guess for the next solve */
+    void interpolate_dofs(PoissonSolver<3>& solver);
+
     /** Return electric field in i-th interpolation point */
     Vec3 get_elfield(const int i) const {
         require(i >= 0 && i < size(), "Invalid index: " + d2s(i));
@@ -234,7 +280,8 @@ public:
     using SolutionReader::interpolate;
     void interpolate(const AtomReader &reader);
 
-    /** Interpolate and export solution on the mesh DOFs of the FEM solver */
+    /** Interpolate temperatures and potentials on the mesh DOFs of the FEM solvers
+     * and use them as the initial guess for the next solve */
     void interpolate_dofs(CurrentHeatSolver<3>& solver, const TetgenMesh* mesh);
 
     /** Compute data that Berendsen thermostat requires for re-using old solution */
@@ -272,6 +319,7 @@ private:
     vector<vector<int>> tet2atoms;
     vector<double> fem_temp;
     vector<double> temperatures;
+    vector<double> potentials;
     vector<double> lambdas;
     double kin_energy;              ///< Kinetic energy added due to Berendsen scaling [eV]
 
@@ -0,0 +1,431 @@
+/*
+ * AmgPreconditioner.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "AmgPreconditioner.h"
+#include "Macros.h"
+
+#include <cmath>
+
+using namespace dealii;
+using namespace std;
+
+namespace femocs {
+
+AmgPreconditioner::AdditionalData::AdditionalData(const double threshold_, const int n_coarse_,
+        const int max_levels_, const int n_smooth_) :
+        threshold(threshold_), n_coarse(n_coarse_), max_levels(max_levels_), n_smooth(n_smooth_)
+{}
+
+void AmgPreconditioner::CsrMatrix::vmult(double* dst, const double* src) const {
+    for (int i = 0; i < n_rows; ++i) {
+        double sum = 0;
+        for (int k = starts[i]; k < starts[i+1]; ++k)
+            sum += vals[k] * src[cols[k]];
+        dst[i] = sum;
+    }
+}
+
+void AmgPreconditioner::CsrMatrix::vmult_add(double* dst, const double* src) const {
+    for (int i = 0; i < n_rows; ++i) {
+        double sum = 0;
+        for (int k = starts[i]; k < starts[i+1]; ++k)
+            sum += vals[k] * src[cols[k]];
+        dst[i] += sum;
+    }
+}
+
+AmgPreconditioner::CsrMatrix AmgPreconditioner::CsrMatrix::transpose() const {
+    CsrMatrix T;
+    T.n_rows = n_cols;
+    T.n_cols = n_rows;
+    T.starts.assign(n_cols + 1, 0);
+    T.cols.resize(nnz());
+    T.vals.resize(nnz());
+
+    for (int c : cols)
+        T.starts[c+1]++;
+    for (int i = 0; i < n_cols; ++i)
+        T.starts[i+1] += T.starts[i];
+
+    vector<int> next(T.starts.begin(), T.starts.end() - 1);
+    for (int i = 0; i < n_rows; ++i)
+        for (int k = starts[i]; k < starts[i+1]; ++k) {
+            const int j = next[cols[k]]++;
+            T.cols[j] = i;
+            T.vals[j] = vals[k];
+        }
+
+    return T;
+}
+
+AmgPreconditioner::CsrMatrix AmgPreconditioner::CsrMatrix::multiply(const CsrMatrix &B) const {
+    require(n_cols == B.n_rows, "Incompatible matrix sizes: " + d2s(n_cols) + " vs " + d2s(B.n_rows));
+
+    CsrMatrix C;
+    C.n_rows = n_rows;
+    C.n_cols = B.n_cols;
+    C.starts.resize(n_rows + 1);
+    C.starts[0] = 0;
+
+    // Gustavson's algorithm; marker holds the location of the column in the current row of C
+    vector<int> marker(B.n_cols, -1);
+    for (int i = 0; i < n_rows; ++i) {
+        const int row_start = C.cols.size();
+        for (int ka = starts[i]; ka < starts[i+1]; ++ka) {
+            const int j = cols[ka];
+            const double a = vals[ka];
+            for (int kb = B.starts[j]; kb < B.starts[j+1]; ++kb) {
+                const int c = B.cols[kb];
+                if (marker[c] < row_start) {
+                    marker[c] = C.cols.size();
+                    C.cols.push_back(c);
+                    C.vals.push_back(a * B.vals[kb]);
+                } else
+                    C.vals[marker[c]] += a * B.vals[kb];
+            }
+        }
+        C.starts[i+1] = C.cols.size();
+    }
+
+    return C;
+}
+
+void AmgPreconditioner::initialize(const SparseMatrix<double> &matrix, const AdditionalData &data_) {
+    require(matrix.m() == matrix.n(), "AMG requires square matrix!");
+    data = data_;
+    clear();
+
+    // copy the non-zero entries of the original matrix
+    levels.push_back(Level());
+    CsrMatrix &A = levels[0].A;
+    const int n_rows = matrix.m();
+    A.n_rows = A.n_cols = n_rows;
+    A.starts.resize(n_rows + 1);
+    A.starts[0] = 0;
+    A.cols.reserve(matrix.n_nonzero_elements());
+    A.vals.reserve(matrix.n_nonzero_elements());
+
+    for (int i = 0; i < n_rows; ++i) {
+        for (SparseMatrix<double>::const_iterator it = matrix.begin(i); it != matrix.end(i); ++it) {
+            const int j = it->column();
+            if (it->value() == 0 && i != j) continue;
+            A.cols.push_back(j);
+            A.vals.push_back(it->value());
+        }
+        A.starts[i+1] = A.cols.size();
+    }
+    calc_inv_diag(levels[0]);
+
+    // coarsen until the matrix is small enough or the coarsening stagnates
+    vector<int> aggregates;
+    while (levels.back().A.n_rows > data.n_coarse && (int)levels.size() < data.max_levels) {
+        Level &fine = levels.back();
+        const int n_aggregates = aggregate(fine, aggregates);
+        if (n_aggregates == 0 || n_aggregates > 0.9 * fine.A.n_rows)
+            break;
+
+        calc_prolongator(fine, aggregates, n_aggregates);
+        fine.R = fine.P.transpose();
+
+        // Galerkin coarse matrix R * A * P
+        CsrMatrix coarse_A = fine.R.multiply(fine.A.multiply(fine.P));
+        levels.push_back(Level());
+        levels.back().A = move(coarse_A);
+        calc_inv_diag(levels.back());
+    }
+
+    for (Level &level : levels) {
+        level.x.resize(level.A.n_rows);
+        level.b.resize(level.A.n_rows);
+        level.r.resize(level.A.n_rows);
+    }
+
+    factorize_coarsest();
+}
+
+void AmgPreconditioner::clear() {
+    levels.clear();
+    cholesky.clear();
+}
+
+double AmgPreconditioner::get_operator_complexity() const {
+    if (levels.size() == 0 || levels[0].A.nnz() == 0) return 0;
+
+    double nnz = 0;
+    for (const Level &level : levels)
+        nnz += level.A.nnz();
+    return nnz / levels[0].A.nnz();
+}
+
+void AmgPreconditioner::calc_inv_diag(Level &level) const {
+    const CsrMatrix &A = level.A;
+    level.inv_diag.assign(A.n_rows, 0);
+    for (int i = 0; i < A.n_rows; ++i)
+        for (int k = A.starts[i]; k < A.starts[i+1]; ++k)
+            if (A.cols[k] == i && A.vals[k] != 0)
+                level.inv_diag[i] = 1.0 / A.vals[k];
+}
+
+int AmgPreconditioner::aggregate(const Level &level, vector<int> &aggregates) const {
+    const CsrMatrix &A = level.A;
+    const int n_rows = A.n_rows;
+    const double threshold2 = data.threshold * data.threshold;
+
+    // strongly connected neighbours of every dof
+    vector<int> strong_starts(n_rows + 1, 0);
+    vector<int> strong;
+    strong.reserve(A.nnz());
+    for (int i = 0; i < n_rows; ++i) {
+        for (int k = A.starts[i]; k < A.starts[i+1]; ++k) {
+            const int j = A.cols[k];
+            if (i == j || level.inv_diag[i] == 0 || level.inv_diag[j] == 0) continue;
+            if (A.vals[k] * A.vals[k] * fabs(level.inv_diag[i] * level.inv_diag[j]) > threshold2)
+                strong.push_back(j);
+        }
+        strong_starts[i+1] = strong.size();
+    }
+
+    static constexpr int unassigned = -1;
+    static constexpr int isolated = -2;
+    aggregates.assign(n_rows, unassigned);
+    int n_aggregates = 0;
+
+    // dofs without strong connections (e.g Dirichlet rows) are handled exactly by the smoother
+    for (int i = 0; i < n_rows; ++i)
+        if (strong_starts[i] == strong_starts[i+1])
+            aggregates[i] = isolated;
+
+    // 1st pass: the dofs, whose whole neighbourhood is free, form the root aggregates
+    for (int i = 0; i < n_rows; ++i) {
+        if (aggregates[i] != unassigned) continue;
+        bool all_free = true;
+        for (int k = strong_starts[i]; k < strong_starts[i+1]; ++k)
+            if (aggregates[strong[k]] != unassigned) { all_free = false; break; }
+        if (!all_free) continue;
+
+        aggregates[i] = n_aggregates;
+        for (int k = strong_starts[i]; k < strong_starts[i+1]; ++k)
+            aggregates[strong[k]] = n_aggregates;
+        n_aggregates++;
+    }
+
+    // 2nd pass: attach the remaining dofs to the neighbouring root aggregate
+    vector<int> roots = aggregates;
+    for (int i = 0; i < n_rows; ++i) {
+        if (aggregates[i] != unassigned) continue;
+        for (int k = strong_starts[i]; k < strong_starts[i+1]; ++k)
+            if (roots[strong[k]] >= 0) {
+                aggregates[i] = roots[strong[k]];
+                break;
+            }
+    }
+
+    // 3rd pass: the dofs that are still free form new aggregates with their free neighbours
+    for (int i = 0; i < n_rows; ++i) {
+        if (aggregates[i] != unassigned) continue;
+        aggregates[i] = n_aggregates;
+        for (int k = strong_starts[i]; k < strong_starts[i+1]; ++k)
+            if (aggregates[strong[k]] == unassigned)
+                aggregates[strong[k]] = n_aggregates;
+        n_aggregates++;
+    }
+
+    for (int &a : aggregates)
+        if (a == isolated) a = -1;
+
+    return n_aggregates;
+}
+
+void AmgPreconditioner::calc_prolongator(Level &level, const vector<int> &aggregates,
+        const int n_aggregates) const
+{
+    const CsrMatrix &A = level.A;
+    const int n_rows = A.n_rows;
+
+    // Gershgorin estimate for the spectral radius of D^-1 * A
+    double rho = 0;
+    for (int i = 0; i < n_rows; ++i) {
+        double row_sum = 0;
+        for (int k = A.starts[i]; k < A.starts[i+1]; ++k)
+            row_sum += fabs(A.vals[k]);
+        rho = max(rho, row_sum * fabs(level.inv_diag[i]));
+    }
+    const double omega = rho > 0 ? 4.0 / (3.0 * rho) : 0;
+
+    // P = (I - omega * D^-1 * A) * T, where T is piecewise constant interpolation from aggregates
+    CsrMatrix &P = level.P;
+    P.n_rows = n_rows;
+    P.n_cols = n_aggregates;
+    P.starts.resize(n_rows + 1);
+    P.starts[0] = 0;
+    P.cols.clear();
+    P.vals.clear();
+
+    vector<int> marker(n_aggregates, -1);
+    for (int i = 0; i < n_rows; ++i) {
+        const int row_start = P.cols.size();
+        if (aggregates[i] >= 0) {
+            marker[aggregates[i]] = row_start;
+            P.cols.push_back(aggregates[i]);
+            P.vals.push_back(1.0);
+        }
+
+        const double factor = omega * level.inv_diag[i];
+        for (int k = A.starts[i]; k < A.starts[i+1]; ++k) {
+            const int c = aggregates[A.cols[k]];
+            if (c < 0) continue;
+            if (marker[c] < row_start) {
+                marker[c] = P.cols.size();
+                P.cols.push_back(c);
+                P.vals.push_back(-factor * A.vals[k]);
+            } else
+                P.vals[marker[c]] -= factor * A.vals[k];
+        }
+        P.starts[i+1] = P.cols.size();
+    }
+}
+
+void AmgPreconditioner::factorize_coarsest() {
+    const CsrMatrix &A = levels.back().A;
+    const int n = A.n_rows;
+
+    // dense coarse matrix would be too big; use smoother instead of direct solver
+    if (n > 4 * data.n_coarse) return;
+
+    cholesky.assign(n * n, 0);
+    for (int i = 0; i < n; ++i)
+        for (int k = A.starts[i]; k < A.starts[i+1]; ++k)
+            cholesky[i * n + A.cols[k]] += A.vals[k];
+
+    double max_diag = 0;
+    for (int i = 0; i < n; ++i)
+        max_diag = max(max_diag, fabs(cholesky[i * n + i]));
+    const double eps = 1e-12 * max_diag;
+
+    // lower triangular L with A = L * L^T; rows with vanishing pivot are left out from the solution
+    for (int j = 0; j < n; ++j) {
+        double d = cholesky[j * n + j];
+        for (int k = 0; k < j; ++k)
+            d -= cholesky[j * n + k] * cholesky[j * n + k];
+
+        if (d <= eps) {
+            for (int i = j; i < n; ++i)
+                cholesky[i * n + j] = 0;
+            continue;
+        }
+
+        const double l_jj = sqrt(d);
+        cholesky[j * n + j] = l_jj;
+        for (int i = j + 1; i < n; ++i) {
+            double s = cholesky[i * n + j];
+            for (int k = 0; k < j; ++k)
+                s -= cholesky[i * n + k] * cholesky[j * n + k];
+            cholesky[i * n + j] = s / l_jj;
+        }
+    }
+
+    // upper triangle is not used
+    for (int i = 0; i < n; ++i)
+        for (int j = i + 1; j < n; ++j)
+            cholesky[i * n + j] = 0;
+}
+
+void AmgPreconditioner::solve_coarsest(double* x, const double* b) const {
+    const int n = levels.back().A.n_rows;
+
+    // forward substitution L * y = b
+    for (int i = 0; i < n; ++i) {
+        const double l_ii = cholesky[i * n + i];
+        if (l_ii == 0) { x[i] = 0; continue; }
+        double s = b[i];
+        for (int k = 0; k < i; ++k)
+            s -= cholesky[i * n + k] * x[k];
+        x[i] = s / l_ii;
+    }
+
+    // backward substitution L^T * x = y
+    for (int i = n - 1; i >= 0; --i) {
+        const double l_ii = cholesky[i * n + i];
+        if (l_ii == 0) { x[i] = 0; continue; }
+        double s = x[i];
+        for (int k = i + 1; k < n; ++k)
+            s -= cholesky[k * n + i] * x[k];
+        x[i] = s / l_ii;
+    }
+}
+
+void AmgPreconditioner::gauss_seidel(const Level &level, const bool forward) const {
+    const CsrMatrix &A = level.A;
+    const int n = A.n_rows;
+    const int first = forward ? 0 : n - 1;
+    const int step = forward ? 1 : -1;
+
+    for (int c = 0, i = first; c < n; ++c, i += step) {
+        double s = level.b[i];
+        double diag = 0;
+        for (int k = A.starts[i]; k < A.starts[i+1]; ++k) {
+            const int j = A.cols[k];
+            if (j == i)
+                diag += A.vals[k];
+            else
+                s -= A.vals[k] * level.x[j];
+        }
+        if (diag != 0)
+            level.x[i] = s / diag;
+    }
+}
+
+void AmgPreconditioner::vcycle(const unsigned int l) const {
+    const Level &level = levels[l];
+    std::fill(level.x.begin(), level.x.end(), 0);
+
+    if (l + 1 == levels.size()) {
+        if (cholesky.size() > 0)
+            solve_coarsest(level.x.data(), level.b.data());
+        else {
+            const int n_sweeps = 10 * max(1, data.n_smooth);
+            for (int s = 0; s < n_sweeps; ++s) {
+                gauss_seidel(level, true);
+                gauss_seidel(level, false);
+            }
+        }
+        return;
+    }
+
+    for (int s = 0; s < data.n_smooth; ++s)
+        gauss_seidel(level, true);
+
+    // restrict the residual r = b - A * x to the coarser level
+    const Level &coarse = levels[l+1];
+    level.A.vmult(level.r.data(), level.x.data());
+    for (int i = 0; i < level.A.n_rows; ++i)
+        level.r[i] = level.b[i] - level.r[i];
+    level.R.vmult(coarse.b.data(), level.r.data());
+
+    vcycle(l + 1);
+
+    // prolongate the coarse correction
+    level.P.vmult_add(level.x.data(), coarse.x.data());
+
+    for (int s = 0; s < data.n_smooth; ++s)
+        gauss_seidel(level, false);
+}
+
+void AmgPreconditioner::vmult(Vector<double> &dst, const Vector<double> &src) const {
+    require(levels.size() > 0, "AMG preconditioner is not initialized!");
+    const Level &finest = levels[0];
+    const int n = finest.A.n_rows;
+    require(n == (int)src.size() && n == (int)dst.size(), "Mismatch between vector and matrix sizes: "
+            + d2s(src.size()) + " vs " + d2s(n));
+
+    for (int i = 0; i < n; ++i)
+        finest.b[i] = src[i];
+    vcycle(0);
+    for (int i = 0; i < n; ++i)
+        dst[i] = finest.x[i];
+}
+
+} // namespace femocs
@@ -62,6 +62,8 @@ Config::Config() {
 
     field.E0 = 0.0;
     field.ssor_param = 1.2;
+    field.preconditioner = "ssor";
+    field.matrix_free = false;
     field.cg_tolerance = 1e-9;
     field.n_cg = 10000;
     field.V0 = 0.0;
@@ -77,8 +79,13 @@ Config::Config() {
     heating.n_cg = 2000;
     heating.cg_tolerance = 1e-9;
     heating.ssor_param = 1.2;         // 1.2 is known to work well with Laplace
+    heating.preconditioner = "ssor";
+    heating.time_scheme = "euler";
+    heating.n_newton = 20;
+    heating.newton_tolerance = 1e-6;
     heating.delta_time = 10.0;
     heating.dt_max = 1.0e5;
+    heating.dt_tolerance = 0.0;
     heating.tau = 100.0;
     heating.T_min = 0.0;
     heating.T_max = 1e5;
@@ -89,6 +96,11 @@ Config::Config() {
     emission.omega = 0.0;
     emission.J_min = 0.0;
     emission.J_max = 1e-4;
+    emission.getelec_reentrant = false;
+    emission.cache_ftol = 0.0;
+    emission.cache_ttol = 0.0;
+    emission.table_tol = 0.0;
+    emission.table_file = "in/emission_table";
 
     force.mode = "none";
     force.beta = 1.0;
@@ -113,6 +125,14 @@ Config::Config() {
     pic.periodic = false;
     pic.landau_log = 13.0;
     pic.max_injected = 50000;
+    pic.sort_period = 10;
+    pic.particles_per_cell = 0;
+    pic.max_subcycles = 1;
+    pic.subcycle_tol = 0.01;
+    pic.subcycle_shift = 0.5;
+    pic.adaptive_dt = false;
+    pic.courant = 0.5;
+    pic.dt_min = 1e-3;
 
     scharge.convergence = 1.;
 }
@@ -167,6 +187,11 @@ void Config::read_all(const string& fname, bool full_run) {
     read_command("emitter_blunt", emission.blunt);
     read_command("sc_omega", emission.omega);
     read_command("emitter_cold", emission.cold);
+    read_command("getelec_reentrant", emission.getelec_reentrant);
+    read_command("emission_cache_ftol", emission.cache_ftol);
+    read_command("emission_cache_ttol", emission.cache_ttol);
+    read_command("emission_table_tol", emission.table_tol);
+    read_command("emission_table_file", emission.table_file);
 
     read_command("heat_mode", heating.mode);
     read_command("rhofile", heating.rhofile);
@@ -175,12 +200,34 @@ void Config::read_all(const string& fname, bool full_run) {
     read_command("heat_ncg", heating.n_cg);
     read_command("heat_cgtol", heating.cg_tolerance);
     read_command("heat_ssor", heating.ssor_param);
+    read_command("heat_precond", heating.preconditioner);
+    read_command("heat_scheme", heating.time_scheme);
+    read_command("heat_nnewton", heating.n_newton);
+    read_command("heat_newtontol", heating.newton_tolerance);
     read_command("heat_dt", heating.delta_time);
     read_command("heat_dtmax", heating.dt_max);
+    read_command("heat_dttol", heating.dt_tolerance);
     read_command("vscale_tau", heating.tau);
 
     read_command("field_mode", field.mode);
     read_command("field_ssor", field.ssor_param);
+    const bool precond_given = read_command("field_precond", field.preconditioner) == 0;
+    read_command("field_matrix_free", field.matrix_free);
+    if (field.matrix_free) {
+        // default preconditioner is accepted silently, explicit sparse matrix ones are ignored with warning
+        if (precond_given && field.preconditioner != "none" && field.preconditioner != "chebyshev")
+            write_silent_msg("Matrix-free field solver uses Chebyshev-Jacobi preconditioner;"
+                    " field_precond = " + field.preconditioner + " is ignored!");
+        if (field.preconditioner != "none")
+            field.preconditioner = "chebyshev";
+    } else {
+        // chebyshev may be left over from an earlier matrix-free run
+        if (!precond_given && field.preconditioner == "chebyshev")
+            field.preconditioner = "ssor";
+        const string &p = field.preconditioner;
+        require(p == "ssor" || p == "ssor_float" || p == "amg" || p == "none",
+                "field_precond = " + p + " is not supported by sparse matrix field solver!");
+    }
     read_command("field_cgtol", field.cg_tolerance);
     read_command("field_ncg", field.n_cg);
     read_command("elfield", field.E0);
@@ -248,6 +295,14 @@ void Config::read_all(const string& fname, bool full_run) {
     read_command("pic_periodic", pic.periodic);
     read_command("pic_landau_log", pic.landau_log);
     read_command("max_injected", pic.max_injected);
+    read_command("pic_sort_period", pic.sort_period);
+    read_command("pic_ppc", pic.particles_per_cell);
+    read_command("pic_max_subcycles", pic.max_subcycles);
+    read_command("pic_subcycle_tol", pic.subcycle_tol);
+    read_command("pic_subcycle_shift", pic.subcycle_shift);
+    read_command("pic_adaptive_dt", pic.adaptive_dt);
+    read_command("pic_courant", pic.courant);
+    read_command("pic_dtmin", pic.dt_min);
     
     read_command("SC_converge_criterion", scharge.convergence);
 
@@ -83,11 +83,11 @@ EmissionSolver<dim>::EmissionSolver(Triangulation<dim> *tria, vector<double>* bc
 
 template<int dim>
 HeatSolver<dim>::HeatSolver() :
-        EmissionSolver<dim>(), current_solver(NULL), one_over_delta_time(0) {}
+        EmissionSolver<dim>(), current_solver(NULL), one_over_delta_time(0), steady_jacobian(false) {}
 
 template<int dim>
 HeatSolver<dim>::HeatSolver(Triangulation<dim> *tria, const CurrentSolver<dim> *cs, vector<double>* bcs) :
-        EmissionSolver<dim>(tria, bcs), current_solver(cs), one_over_delta_time(0) {}
+        EmissionSolver<dim>(tria, bcs), current_solver(cs), one_over_delta_time(0), steady_jacobian(false) {}
 
 template<int dim>
 void HeatSolver<dim>::write_vtk(ofstream& out) const {
@@ -109,13 +109,29 @@ void HeatSolver<dim>::setup_system() {
     const unsigned int n_dofs = this->size();
     joule_heat.reinit(n_dofs);
     total_heat.reinit(n_dofs);
+    prev_potential.reinit(0);
+    prev_surface_heat.reinit(0);
+    saved_solution.reinit(0);
     this->dof_volume.resize(n_dofs);
+
+    this->calc_cell_geometry(cell_geometry);
 }
 
 template<int dim>
 void HeatSolver<dim>::assemble(const double delta_time) {
+    require(this->conf, "NULL config can't be used!");
+    const bool crank_nicolson = this->conf->time_scheme == "crank-nicolson";
+    require(crank_nicolson || this->conf->time_scheme == "euler",
+            "Unimplemented time integration scheme: " + this->conf->time_scheme);
+
+    assemble(delta_time, crank_nicolson);
+}
+
+template<int dim>
+void HeatSolver<dim>::assemble(const double delta_time, const bool crank_nicolson) {
     require(current_solver, "NULL current solver can't be used!");
     require(delta_time > 0, "Invalid delta time: " + d2s(delta_time));
+    require(cell_geometry.n_cells() == this->tria->n_active_cells(), "Cell geometry is not calculated!");
 
     this->one_over_delta_time = 1.0 / delta_time;
     this->system_matrix = 0;
@@ -128,7 +144,8 @@ void HeatSolver<dim>::assemble(const double delta_time) {
     const unsigned int n_q_points = quadrature_formula.size();
 
     WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
-            std::bind(&HeatSolver<dim>::assemble_local_cell,
+            std::bind(crank_nicolson ? &HeatSolver<dim>::assemble_local_cell_crank_nicolson
+                            : &HeatSolver<dim>::assemble_local_cell,
                     this,
                     std::placeholders::_1,
                     std::placeholders::_2,
@@ -137,7 +154,7 @@ void HeatSolver<dim>::assemble(const double delta_time) {
                     this,
                     std::placeholders::_1,
                     std::ref(system)),
-            ScratchData(this->fe, quadrature_formula, update_values | update_gradients | update_quadrature_points | update_JxW_values),
+            ScratchData(this->fe, quadrature_formula, update_default),
             CopyData(n_dofs, n_q_points)
     );
 
@@ -145,251 +162,283 @@ void HeatSolver<dim>::assemble(const double delta_time) {
         this->joule_heat = this->system_rhs;
         this->calc_dof_volumes();
     }
-    this->assemble_rhs(BoundaryID::copper_surface);
+
+    if (crank_nicolson) {
+        // average the Nottingham heat over the previous and current time step
+        Vector<double> surface_heat(this->system_rhs.size());
+        surface_heat.swap(this->system_rhs);
+        this->assemble_rhs(BoundaryID::copper_surface);
+        surface_heat.swap(this->system_rhs);
+
+        if (prev_surface_heat.size() == surface_heat.size())
+            this->system_rhs.add(0.5, surface_heat, 0.5, prev_surface_heat);
+        else
+            this->system_rhs += surface_heat;
+
+        prev_surface_heat.swap(surface_heat);
+        prev_potential = current_solver->solution;
+    } else
+        this->assemble_rhs(BoundaryID::copper_surface);
+
     if (this->write_time()) this->total_heat = this->system_rhs;
     this->append_dirichlet(BoundaryID::copper_bottom, this->dirichlet_bc_value);
     this->apply_dirichlet();
 }
 
 template<int dim>
-void HeatSolver<dim>::assemble_crank_nicolson(const double delta_time) {
-    require(false, "Implementation of Crank-Nicolson assembly not verified!");
-
-    /* TODO:
-     * change temperature_grad to temperature
-     * add prev_nottingham values
-     * interpolate prev_potential and prev_nottingham for current mesh
-     *   prev_potential could be read from heat_transfer
-     *   for nottingham something else should be done...
-     */
-
-    /*
-    require(current_solver, "NULL current solver can't be used!");
+void HeatSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+        ScratchData &scratch_data, CopyData &copy_data) const
+{
+    const unsigned int n_dofs = copy_data.n_dofs;
+    const unsigned int n_q_points = copy_data.n_q_points;
 
-    const double gamma = cu_rho_cp / delta_time;
-    this->system_matrix = 0;
-    this->system_rhs = 0;
+    const double gamma = cu_rho_cp * one_over_delta_time;
 
-    QGauss<dim> quadrature_formula(this->quadrature_degree);
-    QGauss<dim-1> face_quadrature_formula(this->quadrature_degree);
+    // The other solution values in the cell quadrature points
+    vector<Tensor<1, dim>> potential_gradients(n_q_points);
+    vector<double> prev_temperatures(n_q_points);
 
-    // Heating finite element values
-    FEValues<dim> fe_values(this->fe, quadrature_formula,
-            update_values | update_gradients | update_quadrature_points | update_JxW_values);
-    FEFaceValues<dim> fe_face_values(this->fe, face_quadrature_formula,
-            update_values | update_quadrature_points | update_JxW_values);
+    const CellGeometry &geometry = cell_geometry;
+    const unsigned int c = cell->active_cell_index();
+    geometry.get_function_values(c, this->solution, prev_temperatures);
+    geometry.get_function_gradients(c, current_solver->solution, potential_gradients);
 
-    // Finite element values for accessing current calculation
-    FEValues<dim> fe_values_current(current_solver->fe, quadrature_formula, update_gradients);
+    // Conductivities in the quadrature points
+    vector<double> kappas, sigmas;
+    this->pq->kappa(prev_temperatures, kappas);
+    this->pq->sigma(prev_temperatures, sigmas);
 
-    const unsigned int dofs_per_cell = this->fe.dofs_per_cell;
-    const unsigned int n_q_points = quadrature_formula.size();
-    const unsigned int n_face_q_points = face_quadrature_formula.size();
+    // Local matrix assembly
+    copy_data.cell_matrix = 0;
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        double kappa = kappas[q];
+
+        for (unsigned int i = 0; i < n_dofs; ++i) {
+            for (unsigned int j = 0; j < n_dofs; ++j) {
+                copy_data.cell_matrix(i, j) += geometry.JxW(c, q) * (
+                        gamma * geometry.shape_value(i, q) * geometry.shape_value(j, q) // Mass matrix
+                        + kappa * geometry.shape_grad(c, i, q) * geometry.shape_grad(c, j, q) );
+            }
+        }
+    }
+
+    // Local right-hand-side vector assembly
+    copy_data.cell_rhs = 0;
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        double pot_grad_squared = potential_gradients[q].norm_square();
+        double temperature = prev_temperatures[q];
+        double sigma = sigmas[q];
+
+        for (unsigned int i = 0; i < n_dofs; ++i) {
+            copy_data.cell_rhs(i) += geometry.JxW(c, q) * geometry.shape_value(i, q)
+                    * (gamma * temperature + sigma * pot_grad_squared);
+        }
+    }
 
-    FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
-    Vector<double> cell_rhs(dofs_per_cell);
+    // Obtain dof indices for updating global matrix and right-hand-side vector
+    const types::global_dof_index* dof_indices = geometry.dof_indices(c);
+    copy_data.dof_indices.assign(dof_indices, dof_indices + n_dofs);
+}
 
-    vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+template<int dim>
+void HeatSolver<dim>::assemble_local_cell_crank_nicolson(const typename DoFHandler<dim>::active_cell_iterator &cell,
+        ScratchData &scratch_data, CopyData &copy_data) const
+{
+    const unsigned int n_dofs = copy_data.n_dofs;
+    const unsigned int n_q_points = copy_data.n_q_points;
+
+    const double gamma = cu_rho_cp * one_over_delta_time;
+
+    // In the first step after mesh change there is no previous potential available
+    const Vector<double>& prev_pot = (prev_potential.size() == current_solver->solution.size()) ?
+            prev_potential : current_solver->solution;
 
-    // ---------------------------------------------------------------------------------------------
     // The other solution values in the cell quadrature points
-    vector<Tensor<1, dim>> potential_grads(n_q_points);
-    vector<Tensor<1, dim>> prev_potential_grads(n_q_points);
+    vector<Tensor<1, dim>> potential_gradients(n_q_points);
+    vector<Tensor<1, dim>> prev_potential_gradients(n_q_points);
     vector<double> prev_temperatures(n_q_points);
-    vector<Tensor<1, dim>> prev_temperature_grads(n_q_points);
-    // ---------------------------------------------------------------------------------------------
-
-    typename DoFHandler<dim>::active_cell_iterator cell = this->dof_handler.begin_active();
-    typename DoFHandler<dim>::active_cell_iterator current_cell = current_solver->dof_handler.begin_active();
-
-    int face_index = 0;
-    for (; cell != this->dof_handler.end(); ++cell, ++current_cell) {
-        fe_values.reinit(cell);
-        cell_matrix = 0;
-        cell_rhs = 0;
-
-        fe_values.get_function_values(this->solution_save, prev_temperatures);
-        fe_values.get_function_gradients(this->solution_save, prev_temperature_grads);
-
-        fe_values_current.reinit(current_cell);
-        fe_values_current.get_function_gradients(current_solver->solution, potential_grads);
-        fe_values_current.get_function_gradients(current_solver->solution_save, prev_potential_grads);
-
-        // ----------------------------------------------------------------------------------------
-        // Local matrix assembly
-        // ----------------------------------------------------------------------------------------
-        for (unsigned int q = 0; q < n_q_points; ++q) {
-
-            double temperature = prev_temperatures[q];
-            double kappa = this->pq->kappa(temperature);
-            double sigma = this->pq->sigma(temperature);
-
-            Tensor<1, dim> temperature_grad = prev_temperature_grads[q];
-
-            double pot_grad_squared = potential_grads[q].norm_square();
-            double prev_pot_grad_squared = prev_potential_grads[q].norm_square();
-
-            for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                for (unsigned int j = 0; j < dofs_per_cell; ++j) {
-                    cell_matrix(i, j) += fe_values.JxW(q) * (
-                            gamma*fe_values.shape_value(i, q) * fe_values.shape_value(j, q) // Mass matrix
-                            + 0.5*kappa*fe_values.shape_grad(i, q) * fe_values.shape_grad(j, q) );
-                }
-                cell_rhs(i) += fe_values.JxW(q) * (
-                        gamma*fe_values.shape_value(i, q)*temperature
-                        - 0.5*kappa*fe_values.shape_grad(i, q)*temperature_grad  // TODO check this
-                        + 0.5*sigma*fe_values.shape_value(i, q)*(pot_grad_squared+prev_pot_grad_squared) );
-            }
-        }
+    vector<Tensor<1, dim>> prev_temperature_gradients(n_q_points);
+
+    const CellGeometry &geometry = cell_geometry;
+    const unsigned int c = cell->active_cell_index();
+    geometry.get_function_values(c, this->solution, prev_temperatures);
+    geometry.get_function_gradients(c, this->solution, prev_temperature_gradients);
+    geometry.get_function_gradients(c, current_solver->solution, potential_gradients);
+    geometry.get_function_gradients(c, prev_pot, prev_potential_gradients);
 
-        // ----------------------------------------------------------------------------------------
-        // Local right-hand side assembly
-        // ----------------------------------------------------------------------------------------
-        // Nottingham BC at the copper surface
-        for (unsigned int f = 0; f < GeometryInfo<dim>::faces_per_cell; ++f) {
-            if (cell->face(f)->boundary_id() == BoundaryID::copper_surface) {
-                fe_face_values.reinit(cell, f);
-                double nottingham_heat = this->get_face_bc(face_index++);
-
-                for (unsigned int q = 0; q < n_face_q_points; ++q) {
-                    for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                        cell_rhs(i) += fe_face_values.shape_value(i, q)
-                                * nottingham_heat * fe_face_values.JxW(q);
-                    }
-                }
+    // Conductivities in the quadrature points
+    vector<double> kappas, sigmas;
+    this->pq->kappa(prev_temperatures, kappas);
+    this->pq->sigma(prev_temperatures, sigmas);
+
+    // Local matrix assembly
+    copy_data.cell_matrix = 0;
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        double kappa = kappas[q];
+
+        for (unsigned int i = 0; i < n_dofs; ++i) {
+            for (unsigned int j = 0; j < n_dofs; ++j) {
+                copy_data.cell_matrix(i, j) += geometry.JxW(c, q) * (
+                        gamma * geometry.shape_value(i, q) * geometry.shape_value(j, q) // Mass matrix
+                        + 0.5 * kappa * geometry.shape_grad(c, i, q) * geometry.shape_grad(c, j, q) );
             }
         }
+    }
 
-        cell->get_dof_indices(local_dof_indices);
-        for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-            for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                this->system_matrix.add(local_dof_indices[i], local_dof_indices[j], cell_matrix(i, j));
+    // Local right-hand-side vector assembly
+    copy_data.cell_rhs = 0;
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        double pot_grad_squared = potential_gradients[q].norm_square();
+        double prev_pot_grad_squared = prev_potential_gradients[q].norm_square();
+        double temperature = prev_temperatures[q];
+        double kappa = kappas[q];
+        double sigma = sigmas[q];
 
-            this->system_rhs(local_dof_indices[i]) += cell_rhs(i);
+        for (unsigned int i = 0; i < n_dofs; ++i) {
+            copy_data.cell_rhs(i) += geometry.JxW(c, q) * (
+                    geometry.shape_value(i, q)
+                    * (gamma * temperature + 0.5 * sigma * (pot_grad_squared + prev_pot_grad_squared))
+                    - 0.5 * kappa * geometry.shape_grad(c, i, q) * prev_temperature_gradients[q] );
         }
     }
-    //*/
+
+    // Obtain dof indices for updating global matrix and right-hand-side vector
+    const types::global_dof_index* dof_indices = geometry.dof_indices(c);
+    copy_data.dof_indices.assign(dof_indices, dof_indices + n_dofs);
+}
+
+template<int dim>
+double HeatSolver<dim>::solve_embedded(const double delta_time, int &n_cg) {
+    // store the state before the step to be able to reject it
+    saved_solution = this->solution;
+    saved_prev_potential = prev_potential;
+    saved_prev_surface_heat = prev_surface_heat;
+
+    // first order solution
+    assemble(delta_time, false);
+    n_cg = this->solve();
+    if (n_cg < 0) return 0;
+    Vector<double> euler_solution(this->solution);
+
+    // second order solution that starts from the same temperature
+    // and uses first order solution as an initial guess
+    this->solution = saved_solution;
+    assemble(delta_time, true);
+    this->solution = euler_solution;
+    n_cg = this->solve();
+    if (n_cg < 0) return 0;
+
+    euler_solution -= this->solution;
+    return euler_solution.linfty_norm();
+}
+
+template<int dim>
+void HeatSolver<dim>::reject_step() {
+    require(saved_solution.size() == this->solution.size(), "No time step to reject!");
+    this->solution = saved_solution;
+    prev_potential = saved_prev_potential;
+    prev_surface_heat = saved_prev_surface_heat;
 }
 
 template<int dim>
-void HeatSolver<dim>::assemble_euler_implicit(const double delta_time) {
+double HeatSolver<dim>::assemble_steady(const bool with_jacobian) {
     require(current_solver, "NULL current solver can't be used!");
+    require(cell_geometry.n_cells() == this->tria->n_active_cells(), "Cell geometry is not calculated!");
 
-    const double gamma = cu_rho_cp / delta_time;
-    this->system_matrix = 0;
+    steady_jacobian = with_jacobian;
+    if (with_jacobian) this->system_matrix = 0;
     this->system_rhs = 0;
 
+    LinearSystem system(&this->system_rhs, &this->system_matrix);
     QGauss<dim> quadrature_formula(this->quadrature_degree);
 
-    // Heating finite element values
-    FEValues<dim> fe_values(this->fe, quadrature_formula,
-            update_values | update_gradients | update_quadrature_points | update_JxW_values);
-
-    const unsigned int dofs_per_cell = this->fe.dofs_per_cell;
+    const unsigned int n_dofs = this->fe.dofs_per_cell;
     const unsigned int n_q_points = quadrature_formula.size();
 
-    FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
-    Vector<double> cell_rhs(dofs_per_cell);
-
-    vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
-
-    // The other solution values in the cell quadrature points
-    vector<Tensor<1, dim>> potential_gradients(n_q_points);
-    vector<double> prev_temperatures(n_q_points);
-
-    typename DoFHandler<dim>::active_cell_iterator cell = this->dof_handler.begin_active();
-
-    for (; cell != this->dof_handler.end(); ++cell) {
-        fe_values.reinit(cell);
-        fe_values.get_function_values(this->solution, prev_temperatures);
-        fe_values.get_function_gradients(current_solver->solution, potential_gradients);
-
-        // Local matrix assembly
-        cell_matrix = 0;
-        for (unsigned int q = 0; q < n_q_points; ++q) {
-            double temperature = prev_temperatures[q];
-            double kappa = this->pq->kappa(temperature);
-
-            for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                for (unsigned int j = 0; j < dofs_per_cell; ++j) {
-                    cell_matrix(i, j) += fe_values.JxW(q) * (
-                            gamma * fe_values.shape_value(i, q) * fe_values.shape_value(j, q) // Mass matrix
-                            + kappa * fe_values.shape_grad(i, q) * fe_values.shape_grad(j, q) );
-                }
-            }
-        }
-
-        // Local right-hand-side vector assembly
-        cell_rhs = 0;
-        for (unsigned int q = 0; q < n_q_points; ++q) {
-            double pot_grad_squared = potential_gradients[q].norm_square();
-            double temperature = prev_temperatures[q];
-            double sigma = this->pq->sigma(temperature);
+    WorkStream::run(this->dof_handler.begin_active(),this->dof_handler.end(),
+            std::bind(&HeatSolver<dim>::assemble_local_cell_steady,
+                    this,
+                    std::placeholders::_1,
+                    std::placeholders::_2,
+                    std::placeholders::_3),
+            std::bind(with_jacobian ? &HeatSolver<dim>::copy_global_cell : &HeatSolver<dim>::copy_global_rhs,
+                    this,
+                    std::placeholders::_1,
+                    std::ref(system)),
+            ScratchData(this->fe, quadrature_formula, update_default),
+            CopyData(n_dofs, n_q_points)
+    );
 
-            for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-                cell_rhs(i) += fe_values.JxW(q) * fe_values.shape_value(i, q)
-                        * (gamma * temperature + sigma * pot_grad_squared);
-            }
-        }
+    this->assemble_rhs(BoundaryID::copper_surface);
 
-        // Update global matrix and right-hand-side vector
-        cell->get_dof_indices(local_dof_indices);
-        for (unsigned int i = 0; i < dofs_per_cell; ++i) {
-            this->system_rhs(local_dof_indices[i]) += cell_rhs(i);
+    // temperature on Dirichlet boundary is fixed, so the residual there is meaningless
+    for (auto const &bv : this->boundary_values)
+        this->system_rhs[bv.first] = 0;
 
-            for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                this->system_matrix.add(local_dof_indices[i], local_dof_indices[j], cell_matrix(i, j));
-        }
-    }
+    return this->system_rhs.l2_norm();
 }
 
 template<int dim>
-void HeatSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+void HeatSolver<dim>::assemble_local_cell_steady(const typename DoFHandler<dim>::active_cell_iterator &cell,
         ScratchData &scratch_data, CopyData &copy_data) const
 {
     const unsigned int n_dofs = copy_data.n_dofs;
     const unsigned int n_q_points = copy_data.n_q_points;
 
-    const double gamma = cu_rho_cp * one_over_delta_time;
-
-    // The other solution values in the cell quadrature points
+    // The solution values in the cell quadrature points
     vector<Tensor<1, dim>> potential_gradients(n_q_points);
-    vector<double> prev_temperatures(n_q_points);
-
-    scratch_data.fe_values.reinit(cell);
-    scratch_data.fe_values.get_function_values(this->solution, prev_temperatures);
-    scratch_data.fe_values.get_function_gradients(current_solver->solution, potential_gradients);
+    vector<double> temperatures(n_q_points);
+    vector<Tensor<1, dim>> temperature_gradients(n_q_points);
+
+    const CellGeometry &geometry = cell_geometry;
+    const unsigned int c = cell->active_cell_index();
+    geometry.get_function_values(c, this->solution, temperatures);
+    geometry.get_function_gradients(c, this->solution, temperature_gradients);
+    geometry.get_function_gradients(c, current_solver->solution, potential_gradients);
+
+    // Conductivities and their derivatives in the quadrature points
+    vector<double> kappas, sigmas, dkappas, dsigmas;
+    this->pq->kappa(temperatures, kappas);
+    this->pq->sigma(temperatures, sigmas);
+    if (steady_jacobian) {
+        this->pq->dkappa(temperatures, dkappas);
+        this->pq->dsigma(temperatures, dsigmas);
+    }
 
-    // Local matrix assembly
     copy_data.cell_matrix = 0;
+    copy_data.cell_rhs = 0;
     for (unsigned int q = 0; q < n_q_points; ++q) {
-        double temperature = prev_temperatures[q];
-        double kappa = this->pq->kappa(temperature);
+        double pot_grad_squared = potential_gradients[q].norm_square();
+        double kappa = kappas[q];
+        double sigma = sigmas[q];
 
+        // Minus residual: Joule heat minus heat conduction
         for (unsigned int i = 0; i < n_dofs; ++i) {
-            for (unsigned int j = 0; j < n_dofs; ++j) {
-                copy_data.cell_matrix(i, j) += scratch_data.fe_values.JxW(q) * (
-                        gamma * scratch_data.fe_values.shape_value(i, q) * scratch_data.fe_values.shape_value(j, q) // Mass matrix
-                        + kappa * scratch_data.fe_values.shape_grad(i, q) * scratch_data.fe_values.shape_grad(j, q) );
-            }
+            copy_data.cell_rhs(i) += geometry.JxW(c, q) * (
+                    sigma * pot_grad_squared * geometry.shape_value(i, q)
+                    - kappa * geometry.shape_grad(c, i, q) * temperature_gradients[q] );
         }
-    }
 
-    // Local right-hand-side vector assembly
-    copy_data.cell_rhs = 0;
-    for (unsigned int q = 0; q < n_q_points; ++q) {
-        double pot_grad_squared = potential_gradients[q].norm_square();
-        double temperature = prev_temperatures[q];
-        double sigma = this->pq->sigma(temperature);
+        if (!steady_jacobian) continue;
+
+        // Jacobian: derivative of the residual with respect to the nodal temperatures
+        double dkappa = dkappas[q];
+        double dsigma = dsigmas[q];
 
         for (unsigned int i = 0; i < n_dofs; ++i) {
-            copy_data.cell_rhs(i) += scratch_data.fe_values.JxW(q) * scratch_data.fe_values.shape_value(i, q)
-                    * (gamma * temperature + sigma * pot_grad_squared);
+            double grad_i_grad_T = geometry.shape_grad(c, i, q) * temperature_gradients[q];
+            for (unsigned int j = 0; j < n_dofs; ++j) {
+                copy_data.cell_matrix(i, j) += geometry.JxW(c, q) * (
+                        kappa * geometry.shape_grad(c, i, q) * geometry.shape_grad(c, j, q)
+                        + (dkappa * grad_i_grad_T - dsigma * pot_grad_squared * geometry.shape_value(i, q))
+                        * geometry.shape_value(j, q) );
+            }
         }
     }
 
     // Obtain dof indices for updating global matrix and right-hand-side vector
-    cell->get_dof_indices(copy_data.dof_indices);
+    const types::global_dof_index* dof_indices = geometry.dof_indices(c);
+    copy_data.dof_indices.assign(dof_indices, dof_indices + n_dofs);
 }
 
 /* ==================================================================
@@ -420,6 +469,8 @@ void CurrentSolver<dim>::write_vtk(ofstream& out) const {
 template<int dim>
 void CurrentSolver<dim>::assemble() {
     require(heat_solver, "NULL heat solver can't be used!");
+    require(heat_solver->cell_geometry.n_cells() == this->tria->n_active_cells(),
+            "Cell geometry is not calculated!");
 
     this->system_matrix = 0;
     this->system_rhs = 0;
@@ -440,7 +491,7 @@ void CurrentSolver<dim>::assemble() {
                     this,
                     std::placeholders::_1,
                     std::ref(system)),
-            ScratchData(this->fe, quadrature_formula, update_gradients | update_quadrature_points | update_JxW_values),
+            ScratchData(this->fe, quadrature_formula, update_default),
             CopyData(n_dofs, n_q_points)
     );
 
@@ -459,8 +510,9 @@ void CurrentSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::act
     // The previous temperature values in the cell quadrature points
     vector<double> prev_temperatures(n_q_points);
 
-    scratch_data.fe_values.reinit(cell);
-    scratch_data.fe_values.get_function_values(heat_solver->solution, prev_temperatures);
+    const CellGeometry &geometry = heat_solver->cell_geometry;
+    const unsigned int c = cell->active_cell_index();
+    geometry.get_function_values(c, heat_solver->solution, prev_temperatures);
 
     // Local matrix assembly
     copy_data.cell_matrix = 0;
@@ -470,8 +522,8 @@ void CurrentSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::act
 
         for (unsigned int i = 0; i < n_dofs; ++i) {
             for (unsigned int j = 0; j < n_dofs; ++j) {
-                copy_data.cell_matrix(i, j) += sigma * scratch_data.fe_values.JxW(q) *
-                scratch_data.fe_values.shape_grad(i, q) * scratch_data.fe_values.shape_grad(j, q);
+                copy_data.cell_matrix(i, j) += sigma * geometry.JxW(c, q) *
+                geometry.shape_grad(c, i, q) * geometry.shape_grad(c, j, q);
             }
         }
     }
@@ -480,7 +532,8 @@ void CurrentSolver<dim>::assemble_local_cell(const typename DoFHandler<dim>::act
 //    copy_data.cell_rhs = 0;
 
     // Obtain dof indices for updating global matrix and right-hand-side vector
-    cell->get_dof_indices(copy_data.dof_indices);
+    const types::global_dof_index* dof_indices = geometry.dof_indices(c);
+    copy_data.dof_indices.assign(dof_indices, dof_indices + n_dofs);
 }
 
 /* ==================================================================
@@ -513,6 +566,70 @@ void CurrentHeatSolver<dim>::setup(const double temperature) {
     heat.setup_system();
 }
 
+template<int dim>
+int CurrentHeatSolver<dim>::solve_steady(int &ccg, int &hcg) {
+    require(conf, "NULL config can't be used!");
+    ccg = hcg = 0;
+
+    // Newton updates vanish on the Dirichlet boundary, so the initial guess must satisfy the BCs there
+    heat.append_dirichlet(BoundaryID::copper_bottom, heat.dirichlet_bc_value);
+    for (auto const &bv : heat.boundary_values)
+        heat.solution[bv.first] = bv.second;
+    heat.append_dirichlet(BoundaryID::copper_bottom, 0.0);
+
+    Vector<double> temperature, update;
+    double res_scale = 0;
+    int step;
+
+    for (step = 0; step < conf->n_newton; ++step) {
+        // current density distribution for the latest temperatures
+        current.assemble();
+        int n_cg = current.solve();
+        ccg += abs(n_cg);
+        if (n_cg < 0) return -step - 1;
+
+        // At uniform ambient temperature the heat flux vanishes and the residual equals the
+        // Joule & Nottingham heat sources. This gives a fixed scale for the convergence test,
+        // which stays reachable also when the initial guess is already (nearly) steady.
+        if (step == 0) {
+            temperature = heat.solution;
+            heat.solution = heat.dirichlet_bc_value;
+            res_scale = heat.assemble_steady(false);
+            heat.solution = temperature;
+        }
+
+        const double res = heat.assemble_steady(true);
+        if (step == 0) res_scale = max(res_scale, res);
+        write_log("Newton step " + d2s(step) + ": |R|=" + d2s(res));
+        if (res <= conf->newton_tolerance * res_scale) break;
+
+        // solve the Newton update
+        temperature = heat.solution;
+        heat.solution = 0;
+        heat.apply_dirichlet();
+        n_cg = heat.solve_gmres(conf->n_cg, newton_forcing * res, conf->ssor_param);
+        hcg += abs(n_cg);
+        if (n_cg < 0) return -step - 1;
+        update = heat.solution;
+
+        // damp the update until the residual decreases sufficiently
+        double alpha = 1.0;
+        for (int i = 0; i < n_line_search; ++i) {
+            heat.solution = temperature;
+            heat.solution.add(alpha, update);
+            if (heat.assemble_steady(false) < (1.0 - 1e-4 * alpha) * res)
+                break;
+            alpha *= 0.5;
+        }
+    }
+
+    // restore the actual Dirichlet BCs for the transient solver
+    heat.append_dirichlet(BoundaryID::copper_bottom, heat.dirichlet_bc_value);
+
+    if (step >= conf->n_newton) return -step;
+    return step;
+}
+
 template<int dim>
 void CurrentHeatSolver<dim>::set_dependencies(PhysicalQuantities *pq_, const Config::Heating *conf_) {
     pq = pq_;
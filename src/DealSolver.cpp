@@ -10,6 +10,7 @@
 #include <deal.II/numerics/data_out.h>
 
 #include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_gmres.h>
 #include <deal.II/lac/precondition.h>
 #include <deal.II/lac/dynamic_sparsity_pattern.h>
 
@@ -23,6 +24,8 @@
 #include "Macros.h"
 #include "Globals.h"
 
+#include <omp.h>
+#include <iomanip>
 
 using namespace dealii;
 using namespace std;
@@ -31,11 +34,13 @@ namespace femocs {
 
 template<int dim>
 DealSolver<dim>::DealSolver() :
-        dirichlet_bc_value(0), tria(&triangulation), fe(shape_degree), dof_handler(triangulation) {}
+        dirichlet_bc_value(0), tria(&triangulation), fe(shape_degree), dof_handler(triangulation),
+        preconditioner_param(0), preconditioner_float_param(0), amg_outdated(true) {}
 
 template<int dim>
 DealSolver<dim>::DealSolver(Triangulation<dim> *tr) :
-        dirichlet_bc_value(0), tria(tr), fe(shape_degree), dof_handler(*tr) {}
+        dirichlet_bc_value(0), tria(tr), fe(shape_degree), dof_handler(*tr),
+        preconditioner_param(0), preconditioner_float_param(0), amg_outdated(true) {}
 
 template<int dim>
 DealSolver<dim>::LinearSystem::LinearSystem(Vector<double>* rhs, SparseMatrix<double>* matrix) :
@@ -61,6 +66,79 @@ DealSolver<dim>::CopyData::CopyData(const unsigned dofs_per_cell, const unsigned
     n_dofs(dofs_per_cell), n_q_points(n_qp)
 {}
 
+template<int dim>
+void DealSolver<dim>::CellGeometry::get_function_values(const size_t cell, const Vector<double> &field,
+        vector<double> &field_values) const
+{
+    const types::global_dof_index* dof = dof_indices(cell);
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        double value = 0;
+        for (unsigned int i = 0; i < n_dofs; ++i)
+            value += shape_value(i, q) * field(dof[i]);
+        field_values[q] = value;
+    }
+}
+
+template<int dim>
+void DealSolver<dim>::CellGeometry::get_function_gradients(const size_t cell, const Vector<double> &field,
+        vector<Tensor<1,dim>> &field_grads) const
+{
+    const types::global_dof_index* dof = dof_indices(cell);
+    for (unsigned int q = 0; q < n_q_points; ++q) {
+        Tensor<1,dim> grad;
+        for (unsigned int i = 0; i < n_dofs; ++i)
+            grad += field(dof[i]) * shape_grad(cell, i, q);
+        field_grads[q] = grad;
+    }
+}
+
+template<int dim>
+void DealSolver<dim>::CellGeometry::clear() {
+    n_dofs = n_q_points = 0;
+    values.clear();
+    jxw.clear();
+    grads.clear();
+    dofs.clear();
+}
+
+template<int dim>
+void DealSolver<dim>::calc_cell_geometry(CellGeometry &geometry) const {
+    QGauss<dim> quadrature_formula(quadrature_degree);
+    FEValues<dim> fe_values(fe, quadrature_formula, update_values | update_gradients | update_JxW_values);
+
+    const unsigned int n_dofs = fe.dofs_per_cell;
+    const unsigned int n_q_points = quadrature_formula.size();
+    const size_t n_cells = tria->n_active_cells();
+
+    geometry.n_dofs = n_dofs;
+    geometry.n_q_points = n_q_points;
+    geometry.values.resize(n_q_points * n_dofs);
+    geometry.jxw.resize(n_cells * n_q_points);
+    geometry.grads.resize(n_cells * n_q_points * n_dofs);
+    geometry.dofs.resize(n_cells * n_dofs);
+
+    vector<types::global_dof_index> local_dof_indices(n_dofs);
+    typename DoFHandler<dim>::active_cell_iterator cell = dof_handler.begin_active();
+
+    for (; cell != dof_handler.end(); ++cell) {
+        fe_values.reinit(cell);
+        const size_t c = cell->active_cell_index();
+
+        cell->get_dof_indices(local_dof_indices);
+        for (unsigned int i = 0; i < n_dofs; ++i)
+            geometry.dofs[c * n_dofs + i] = local_dof_indices[i];
+
+        for (unsigned int q = 0; q < n_q_points; ++q) {
+            geometry.jxw[c * n_q_points + q] = fe_values.JxW(q);
+            for (unsigned int i = 0; i < n_dofs; ++i) {
+                geometry.grads[(c * n_q_points + q) * n_dofs + i] = fe_values.shape_grad(i, q);
+                // for Lagrange elements the values don't depend on the shape of the cell
+                geometry.values[q * n_dofs + i] = fe_values.shape_value(i, q);
+            }
+        }
+    }
+}
+
 template<int dim>
 void DealSolver<dim>::copy_global_cell(const CopyData &copy_data, LinearSystem &system) const {
     system.global_rhs->add(copy_data.dof_indices, copy_data.cell_rhs);
@@ -71,6 +149,11 @@ void DealSolver<dim>::copy_global_cell(const CopyData &copy_data, LinearSystem &
     }
 }
 
+template<int dim>
+void DealSolver<dim>::copy_global_rhs(const CopyData &copy_data, LinearSystem &system) const {
+    system.global_rhs->add(copy_data.dof_indices, copy_data.cell_rhs);
+}
+
 template<int dim>
 vector<double> DealSolver<dim>::shape_funs(const Point<dim> &p, int cell_index) const {
     return shape_funs(p, cell_index, StaticMappingQ1<dim,dim>::mapping);
@@ -366,19 +449,31 @@ void DealSolver<dim>::calc_dof_volumes() {
 }
 
 template<int dim>
-void DealSolver<dim>::setup_system() {
+void DealSolver<dim>::setup_system(const bool with_matrix) {
     require(tria->n_used_vertices() > 0, "Can't setup system with no mesh!");
 
+    this->preconditioner.clear();
+    this->preconditioner_param = 0;
+    this->preconditioner_float.clear();
+    this->preconditioner_float_param = 0;
+    this->system_matrix_float.clear();
+    this->amg.clear();
+    this->amg_outdated = true;
     this->dof_handler.distribute_dofs(this->fe);
     this->boundary_values.clear();
 
     const unsigned int n_dofs = size();
 
-    DynamicSparsityPattern dsp(n_dofs);
-    DoFTools::make_sparsity_pattern(this->dof_handler, dsp);
-    this->sparsity_pattern.copy_from(dsp);
+    if (with_matrix) {
+        DynamicSparsityPattern dsp(n_dofs);
+        DoFTools::make_sparsity_pattern(this->dof_handler, dsp);
+        this->sparsity_pattern.copy_from(dsp);
+        this->system_matrix.reinit(this->sparsity_pattern);
+    } else {
+        this->system_matrix.clear();
+        this->sparsity_pattern.reinit(0, 0, 0);
+    }
 
-    this->system_matrix.reinit(this->sparsity_pattern);
     this->system_rhs.reinit(n_dofs);
     this->solution.reinit(n_dofs);
     this->solution = this->dirichlet_bc_value;
@@ -437,24 +532,113 @@ void DealSolver<dim>::append_dirichlet(const int bid, const double value) {
 template<int dim>
 void DealSolver<dim>::apply_dirichlet() {
     MatrixTools::apply_boundary_values(boundary_values, this->system_matrix, this->solution, this->system_rhs);
+    // matrix has changed and the preconditioner must be rebuilt
+    preconditioner_param = 0;
+    preconditioner_float_param = 0;
+    amg_outdated = true;
 }
 
 template<int dim>
-int DealSolver<dim>::solve_cg(int max_iter, double tol, double ssor_param) {
+void DealSolver<dim>::apply_dirichlet_rhs(const Vector<double> &rhs_bc) {
+    require(rhs_bc.size() == system_rhs.size(), "Mismatch between rhs sizes: "
+            + d2s(rhs_bc.size()) + " vs " + d2s(system_rhs.size()));
+
+    // The rows of constrained dofs are fully determined by rhs_bc
+    // and columns of constrained dofs have already been lifted into rhs_bc
+    for (auto const &bv : boundary_values) {
+        system_rhs[bv.first] = 0;
+        solution[bv.first] = bv.second;
+    }
+    system_rhs += rhs_bc;
+}
+
+template<int dim>
+int DealSolver<dim>::solve_cg(int max_iter, double tol, double ssor_param, const string &precond) {
+    require(precond == "ssor" || precond == "ssor_float" || precond == "amg" || precond == "none",
+            "Unimplemented preconditioner: " + precond);
+
+    const double t_start = omp_get_wtime();
     SolverControl solver_control(max_iter, tol);
     SolverCG<> solver(solver_control);
+    int n_steps;
+    try {
+        if (precond == "amg") {
+            if (amg_outdated || amg.get_n_levels() == 0) {
+                amg.initialize(system_matrix);
+                amg_outdated = false;
+            }
+            solver.solve(system_matrix, solution, system_rhs, amg);
+        } else if (precond == "ssor" && ssor_param > 0.0) {
+            if (preconditioner_param != ssor_param) {
+                preconditioner.initialize(system_matrix, ssor_param);
+                preconditioner_param = ssor_param;
+            }
+            solver.solve(system_matrix, solution, system_rhs, preconditioner);
+        } else if (precond == "ssor_float" && ssor_param > 0.0) {
+            if (preconditioner_float_param != ssor_param) {
+                if (system_matrix_float.empty())
+                    system_matrix_float.reinit(sparsity_pattern);
+                system_matrix_float.copy_from(system_matrix);
+                preconditioner_float.initialize(system_matrix_float, ssor_param);
+                preconditioner_float_param = ssor_param;
+            }
+            solver.solve(system_matrix, solution, system_rhs, preconditioner_float);
+        } else
+            solver.solve(system_matrix, solution, system_rhs, PreconditionIdentity());
+
+        n_steps = solver_control.last_step();
+    } catch (exception &exc) {
+        n_steps = -1 * solver_control.last_step();
+    }
+
+    store_solver_stats(solver_control, n_steps, t_start);
+    return n_steps;
+}
+
+template<int dim>
+int DealSolver<dim>::solve_gmres(int max_iter, double tol, double ssor_param) {
+    const double t_start = omp_get_wtime();
+    SolverControl solver_control(max_iter, tol);
+    SolverGMRES<> solver(solver_control);
+    int n_steps;
     try {
         if (ssor_param > 0.0) {
-            PreconditionSSOR<> preconditioner;
-            preconditioner.initialize(system_matrix, ssor_param);
+            if (preconditioner_param != ssor_param) {
+                preconditioner.initialize(system_matrix, ssor_param);
+                preconditioner_param = ssor_param;
+            }
             solver.solve(system_matrix, solution, system_rhs, preconditioner);
         } else
             solver.solve(system_matrix, solution, system_rhs, PreconditionIdentity());
 
-        return solver_control.last_step();
+        n_steps = solver_control.last_step();
     } catch (exception &exc) {
-        return -1 * solver_control.last_step();
+        n_steps = -1 * solver_control.last_step();
     }
+
+    store_solver_stats(solver_control, n_steps, t_start);
+    return n_steps;
+}
+
+template<int dim>
+void DealSolver<dim>::store_solver_stats(const SolverControl &control, const int n_iter, const double t_start) {
+    solver_stats.n_iter = n_iter;
+    solver_stats.res_initial = control.initial_value();
+    solver_stats.res_final = control.last_value();
+    solver_stats.time = omp_get_wtime() - t_start;
+
+    if (!MODES.WRITELOG) return;
+    ofstream out(MODES.OUT_FOLDER + "/solver_stats.dat", ios_base::app);
+    if (!out) return;
+
+    if (first_line(out))
+        out << "timestep time solver dofs n_iter res_initial res_final wall_time\n";
+
+    out << GLOBALS.TIMESTEP << " " << fixed << setprecision(3) << GLOBALS.TIME
+            << " " << get_name() << " " << size() << " " << n_iter
+            << scientific << setprecision(6)
+            << " " << solver_stats.res_initial << " " << solver_stats.res_final
+            << " " << solver_stats.time << "\n";
 }
 
 template<int dim>
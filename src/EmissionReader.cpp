@@ -10,6 +10,36 @@
 using namespace std;
 namespace femocs {
 
+void init_getelec(const double work_function) {
+    static bool initialized = false;
+    if (initialized) return;
+
+    struct emission gt;
+    gt.W = work_function;
+    gt.R = 1000.0;
+    gt.gamma = 10;
+    gt.F = 5.0;
+    gt.Temp = 300.0;
+    gt.mode = 0;
+    gt.approx = 0;
+    cur_dens_c(&gt);
+    initialized = true;
+}
+
+void calc_getelec(struct emission &gt, const bool space_charge, const bool reentrant) {
+    if (reentrant) {
+        if (space_charge) cur_dens_SC(&gt);
+        else cur_dens_c(&gt);
+        return;
+    }
+
+#pragma omp critical(getelec)
+    {
+        if (space_charge) cur_dens_SC(&gt);
+        else cur_dens_c(&gt);
+    }
+}
+
 EmissionReader::EmissionReader(const FieldReader *fr, const HeatReader *hr, Interpolator* i) :
         fields(fr), heat(hr), mesh(NULL), phis_on_line(i)
 {
@@ -30,9 +60,8 @@ void EmissionReader::initialize(const TetgenMesh* m, bool reinit) {
     thetas_SC.resize(n_nodes);
     markers.resize(n_nodes);
 
-    //deallocate and allocate lines
-    rline.resize(n_lines);
-    Vline.resize(n_lines);
+    // results on the old mesh can't be reused
+    cache.assign(n_nodes, CachedEmission());
 
     //Initialise data
     global_data.Jmax = 0.;
@@ -48,20 +77,24 @@ void EmissionReader::initialize(const TetgenMesh* m, bool reinit) {
     stats.Fmax.resize(0);
 }
 
-void EmissionReader::emission_line(const Point3& point, const Vec3& direction, const double rmax) {
+void EmissionReader::emission_line(FieldReader &line, vector<double> &rline, vector<double> &Vline,
+        const Point3& point, const Vec3& direction, const double rmax) const
+{
     const double rmin = 1.e-5 * rmax;
+    rline.resize(n_lines);
+    Vline.resize(n_lines);
 
     // calculate potentials on line starting from face centroid
     // and moving in direction of its norm
-    phis_on_line.reserve(n_lines);
+    line.reserve(n_lines);
     for (int i = 0; i < n_lines; i++){
         rline[i] = rmin + ((rmax - rmin) * i) / (n_lines - 1);
-        phis_on_line.append(point + direction * rline[i]);
+        line.append(point + direction * rline[i]);
     }
-    phis_on_line.calc_interpolation();
+    line.calc_interpolation();
 
     for (int i = 0; i < n_lines; i++){
-        Vline[i] = global_data.multiplier * phis_on_line.get_potential(i);
+        Vline[i] = global_data.multiplier * line.get_potential(i);
         rline[i] *= nm_per_angstrom;
     }
 
@@ -148,88 +181,192 @@ void EmissionReader::calc_effective_region(double threshold, string mode) {
     }
 }
 
+bool EmissionReader::face_emission_input(struct emission &gt, FieldReader &line, vector<double> &rline,
+        vector<double> &Vline, const int face, const double Fmin_line, const bool blunt) const
+{
+    const double F = global_data.multiplier * fields->get_elfield_norm(face);
+    gt.mode = 0;
+    gt.F = angstrom_per_nm * F;
+    gt.Temp = heat->get_temperature(face);
+
+    // Full calculation with line only for high field points
+    if (F <= Fmin_line || blunt)
+        return false;
+
+    int quad = abs(fields->get_marker(face));
+    int tri = mesh->quads.to_tri(quad);
+    emission_line(line, rline, Vline, fields->get_point(face), mesh->tris.get_norm(tri),
+            1.6 * gt.W / F);
+
+    gt.Nr = n_lines;
+    gt.xr = &rline[0];
+    gt.Vr = &Vline[0];
+    gt.mode = -21;  // set mode to potential input data
+    return true;
+}
+
+bool EmissionReader::cache_hit(const CachedEmission &cached, const struct emission &gt, const double V,
+        const double Veff, const Config::Emission &conf) const
+{
+    if (conf.cache_ftol <= 0 || cached.marker < 0)
+        return false;
+
+    auto is_close = [](double value, double ref, double tol) { return fabs(value - ref) <= tol * fabs(ref); };
+    return (V > 0) == (cached.V > 0)
+            && is_close(gt.F, cached.F, conf.cache_ftol)
+            && is_close(V, cached.V, conf.cache_ftol)
+            && is_close(Veff, cached.Veff, conf.cache_ftol)
+            && is_close(gt.Temp, cached.T, conf.cache_ttol);
+}
+
+void EmissionReader::cache_store(CachedEmission &cached, const struct emission &gt, const double V,
+        const double Veff, const int marker) const
+{
+    // don't reuse the results, that GETELEC failed to calculate properly
+    if (gt.ierr != 0) {
+        cached.marker = -1;
+        return;
+    }
+
+    cached.F = gt.F;
+    cached.T = gt.Temp;
+    cached.V = V;
+    cached.Veff = Veff;
+    cached.J = gt.Jem * nm2_per_angstrom2;
+    cached.heat = gt.heat * nm2_per_angstrom2;
+    cached.theta = gt.theta;
+    cached.marker = marker;
+}
+
 int EmissionReader::calc_emission(const Config::Emission &conf, double Veff,
         bool update_eff_region)
 {
     constexpr int J_error = -10;      // error code of current density is outside the limits
-    constexpr int sign_error = -11;   // error code of field in wrong direction
-    constexpr int fitting_error = -2; // error code of model fitting failed
     const int n_faces = fields->size();
 
-    struct emission gt;
-    gt.W = conf.work_function;    // set workfuntion, must be set in conf. script
-    gt.R = 1000.0;       // radius of curvature (overrided by femocs potential distribution)
-    gt.gamma = 10;       // enhancement factor (overrided by femocs potential distribution)
-    double F, J;         // Local field and current density in femocs units
-    bool fitting_failed = false;  // flag of non-fatal error
+    struct emission gt_init;
+    gt_init.W = conf.work_function;    // set workfuntion, must be set in conf. script
+    gt_init.R = 1000.0;       // radius of curvature (overrided by femocs potential distribution)
+    gt_init.gamma = 10;       // enhancement factor (overrided by femocs potential distribution)
+    gt_init.voltage = Veff;
+
+    // The thresholds of choosing the calculation method depend on the maxima on the whole surface.
+    // Calculating them before the emission makes the result independent of the order of the faces.
+    double Fmax = 0;
+    for (int i = 0; i < n_faces; ++i)
+        Fmax = max(Fmax, global_data.multiplier * fields->get_elfield_norm(i));
+    const double Fmin_line = 0.6 * Fmax;
+
+    // the first GETELEC call sets up the library and must not be made in parallel
+    init_getelec(conf.work_function);
+
+    // table doesn't take into account space charge
+    const bool use_table = conf.table_tol > 0 && Veff <= 0;
+    if (use_table)
+        table.prepare(conf.work_function, conf.table_file, conf.getelec_reentrant);
+
+    // faces that need full energy integration
+    vector<char> is_full(n_faces, 0);
+    double Jmax_approx = 0;
+    int n_hits = 0, n_misses = 0, n_tabulated = 0;
+
+    // First pass: simple GTF approximation on all the faces
+#pragma omp parallel
+    {
+        // thread-private GETELEC input and line buffers
+        FieldReader line(phis_on_line);
+        vector<double> rline, Vline;
+
+#pragma omp for schedule(dynamic, 16) reduction(max:Jmax_approx) reduction(+:n_hits,n_misses,n_tabulated)
+        for (int i = 0; i < n_faces; ++i) {
+            struct emission gt = gt_init;
+            bool with_line = face_emission_input(gt, line, rline, Vline, i, Fmin_line, conf.blunt);
+            const double V = with_line ? Vline.back() : 0;
+
+            // reuse the previous result if the input has changed only a little
+            const CachedEmission &cached = cache[i];
+            if (cache_hit(cached, gt, V, Veff, conf)) {
+                current_densities[i] = cached.J;
+                nottingham[i] = cached.heat;
+                thetas_SC[i] = cached.theta;
+                markers[i] = cached.marker;
+                Jmax_approx = max(Jmax_approx, cached.J);
+                n_hits++;
+                continue;
+            }
 
-    global_data.Fmax = 0;
-    global_data.Jmax = 0;
+            // use table if its interpolation is accurate enough;
+            // if the face turns out to have high current, its emission is calculated fully in second pass
+            double J_table, heat_table;
+            const double R = with_line ? EmissionTable::barrier_radius(gt.F, rline, Vline) : gt.R;
+            if (use_table && table.interpolate(J_table, heat_table, gt.F, gt.Temp, R, conf.table_tol)) {
+                current_densities[i] = J_table * nm2_per_angstrom2;
+                nottingham[i] = heat_table * nm2_per_angstrom2;
+                thetas_SC[i] = 1;
+                markers[i] = 3; // marker==3: emission interpolated from table
+                Jmax_approx = max(Jmax_approx, current_densities[i]);
+                n_tabulated++;
+                continue;
+            }
 
-    for (int i = 0; i < n_faces; ++i) {
-        int quad = abs(fields->get_marker(i));
-        int tri = mesh->quads.to_tri(quad);
-        Vec3 normal = mesh->tris.get_norm(tri);
-        double elfield = fields->get_elfield_norm(i);
-
-        // avoid using dot product as field norm, as field and normal are not precisely perpendicular
-        // check, however, that the field and normal are in opposite direction
-//        if (normal.dotProduct(fields->get_elfield(i)) > 0)
-//            return sign_error;
-
-        F = global_data.multiplier * elfield;
-        gt.mode = 0;
-        gt.F = angstrom_per_nm * F;
-        gt.Temp = heat->get_temperature(i);
-        markers[i] = 0; // marker==0: no full calculation
-
-        // Full calculation with line only for high field points
-        if (F > 0.6 * global_data.Fmax && !conf.blunt) {
-            // get emission line data
-            emission_line(fields->get_point(i), normal, 1.6 * conf.work_function / F);
-
-            gt.Nr = n_lines;
-            gt.xr = &rline[0];
-            gt.Vr = &Vline[0];
-            gt.mode = -21;  // set mode to potential input data
-            markers[i] = 1; // marker==1: emission calculated with line
+            gt.approx = 0; // simple GTF approximation
+            calc_getelec(gt, Veff > 0, conf.getelec_reentrant);
+
+            const double J = gt.Jem * nm2_per_angstrom2; // current density in femocs units
+            current_densities[i] = J;
+            nottingham[i] = nm2_per_angstrom2 * gt.heat;
+            thetas_SC[i] = gt.theta;
+            markers[i] = with_line; // marker==0: no full calculation, marker==1: emission calculated with line
+            is_full[i] = gt.ierr != 0;
+            Jmax_approx = max(Jmax_approx, J);
+            cache_store(cache[i], gt, V, Veff, markers[i]);
+            n_misses++;
         }
+    }
 
-        gt.approx = 0; // simple GTF approximation
-        if (Veff <= 0)
-            cur_dens_c(&gt); // calculate emission
-        else
-            cur_dens_SC(&gt);
-
-        J = gt.Jem * nm2_per_angstrom2; // current density in femocs units
-
-        // If J is worth it, calculate with full energy integration
-        if ((J > 0.1 * global_data.Jmax || gt.ierr) && !conf.cold) {
-            gt.approx = 1;
-            if (Veff <= 0)
-                cur_dens_c(&gt); // calculate emission
-            else {
-                gt.voltage = Veff;
-                cur_dens_SC(&gt);
+    // Second pass: if J is worth it, calculate with full energy integration
+    if (!conf.cold) {
+        const double Jmin_full = 0.1 * Jmax_approx;
+        for (int i = 0; i < n_faces; ++i)
+            is_full[i] |= markers[i] != 2 && current_densities[i] > Jmin_full;
+
+#pragma omp parallel
+        {
+            FieldReader line(phis_on_line);
+            vector<double> rline, Vline;
+
+#pragma omp for schedule(dynamic, 4) reduction(+:n_misses)
+            for (int i = 0; i < n_faces; ++i) {
+                if (!is_full[i]) continue;
+
+                struct emission gt = gt_init;
+                bool with_line = face_emission_input(gt, line, rline, Vline, i, Fmin_line, conf.blunt);
+
+                gt.approx = 1;
+                calc_getelec(gt, Veff > 0, conf.getelec_reentrant);
+
+                current_densities[i] = gt.Jem * nm2_per_angstrom2;
+                nottingham[i] = nm2_per_angstrom2 * gt.heat;
+                thetas_SC[i] = gt.theta;
+                markers[i] = 2;
+                cache_store(cache[i], gt, with_line ? Vline.back() : 0, Veff, markers[i]);
+                n_misses++;
             }
-
-//            if (gt.ierr != 0) {
-//                if (gt.ierr == fitting_error)
-//                    fitting_failed = true;
-//                else
-//                    return gt.ierr;
-//            }
-
-            J = gt.Jem * nm2_per_angstrom2;
-            markers[i] = 2;
         }
+    }
 
-        current_densities[i] = J;
-        nottingham[i] = nm2_per_angstrom2 * gt.heat;
-        thetas_SC[i] = gt.theta;
+    cache_stats.n_hits = n_hits;
+    cache_stats.n_misses = n_misses;
+    cache_stats.n_tabulated = n_tabulated;
+    cache_stats.total_hits += n_hits;
+    cache_stats.total_misses += n_misses;
 
-        global_data.Fmax = max(global_data.Fmax, F * gt.theta);
-        global_data.Jmax = max(global_data.Jmax, J); // output data
+    global_data.Fmax = 0;
+    global_data.Jmax = 0;
+    for (int i = 0; i < n_faces; ++i) {
+        double F = global_data.multiplier * fields->get_elfield_norm(i);
+        global_data.Fmax = max(global_data.Fmax, F * thetas_SC[i]);
+        global_data.Jmax = max(global_data.Jmax, current_densities[i]); // output data
     }
 
     if (global_data.Jmax > conf.J_max)
@@ -239,9 +376,6 @@ int EmissionReader::calc_emission(const Config::Emission &conf, double Veff,
         calc_effective_region(0.9, "field");
 
     calculate_globals();
-
-    if (fitting_failed)
-        write_verbose_msg("Model fitting failed. Applied rough FN approximation.");
     return 0;
 }
 
@@ -0,0 +1,201 @@
+/*
+ * EmissionTable.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "EmissionTable.h"
+#include "EmissionReader.h"
+#include "Macros.h"
+#include "getelec.h"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+namespace femocs {
+
+constexpr double EmissionTable::Fmin;
+constexpr double EmissionTable::Fmax;
+constexpr double EmissionTable::Tmin;
+constexpr double EmissionTable::Tmax;
+constexpr double EmissionTable::Rmin;
+constexpr double EmissionTable::Rmax;
+constexpr double EmissionTable::J_floor;
+
+void EmissionTable::prepare(const double W, const string &file_base, const bool reentrant) {
+    if (W == work_function && !empty())
+        return;
+
+    const string file_name = file_base + "_W" + d2s(W, 3) + ".bin";
+    work_function = W;
+    if (read(file_name)) {
+        write_verbose_msg("Emission table read from " + file_name);
+        return;
+    }
+
+    double t0;
+    start_msg(t0, "Calculating emission table");
+    init_getelec(W);
+    calculate(reentrant);
+    calc_errors();
+    end_msg(t0);
+    write(file_name);
+}
+
+void EmissionTable::calculate(const bool reentrant) {
+    const double dlogF = log(Fmax / Fmin) / (nF - 1);
+    const double dT = (Tmax - Tmin) / (nT - 1);
+    const double dlogR = log(Rmax / Rmin) / (nR - 1);
+    const int n_nodes = nF * nT * nR;
+
+    log_J.resize(n_nodes);
+    heat.resize(n_nodes);
+
+#pragma omp parallel for schedule(dynamic, 8)
+    for (int n = 0; n < n_nodes; ++n) {
+        const int i = n / (nT * nR);
+        const int j = (n / nR) % nT;
+        const int k = n % nR;
+
+        struct emission gt;
+        gt.W = work_function;
+        gt.F = Fmin * exp(i * dlogF);
+        gt.Temp = Tmin + j * dT;
+        gt.R = Rmin * exp(k * dlogR);
+        gt.gamma = 10;
+        gt.mode = 0;
+        gt.approx = 1;  // full energy integration
+        calc_getelec(gt, false, reentrant);
+
+        // failed nodes make the surrounding cells unusable
+        if (gt.ierr == 0) {
+            log_J[n] = log(max(J_floor, gt.Jem));
+            heat[n] = gt.heat;
+        } else {
+            log_J[n] = numeric_limits<double>::quiet_NaN();
+            heat[n] = 0;
+        }
+    }
+}
+
+void EmissionTable::calc_errors() {
+    // second difference along the dimension; in the boundary nodes the neighbouring node is used
+    const int n_points[3] = {nF, nT, nR};
+    auto diff2 = [this, &n_points](const int i, const int j, const int k, const int dim) {
+        int ijk[3] = {i, j, k};
+        ijk[dim] = max(1, min(n_points[dim] - 2, ijk[dim]));
+        const int mid = node(ijk[0], ijk[1], ijk[2]);
+        ijk[dim]--;
+        const int prev = node(ijk[0], ijk[1], ijk[2]);
+        ijk[dim] += 2;
+        const int next = node(ijk[0], ijk[1], ijk[2]);
+        return fabs(log_J[prev] - 2 * log_J[mid] + log_J[next]);
+    };
+
+    error.resize((nF - 1) * (nT - 1) * (nR - 1));
+    for (int i = 0; i < nF - 1; ++i)
+        for (int j = 0; j < nT - 1; ++j)
+            for (int k = 0; k < nR - 1; ++k) {
+                // error of linear interpolation is h^2/8 * |f''| in every dimension
+                double dF = 0, dT = 0, dR = 0;
+                for (int c = 0; c < 8; ++c) {
+                    const int ii = i + (c & 1), jj = j + ((c >> 1) & 1), kk = k + ((c >> 2) & 1);
+                    dF = max(dF, diff2(ii, jj, kk, 0));
+                    dT = max(dT, diff2(ii, jj, kk, 1));
+                    dR = max(dR, diff2(ii, jj, kk, 2));
+                    // NaN does not survive max, so it must be checked separately
+                    if (std::isnan(log_J[node(ii, jj, kk)])) dF = numeric_limits<double>::infinity();
+                }
+                error[(i * (nT - 1) + j) * (nR - 1) + k] = (dF + dT + dR) / 8.0;
+            }
+}
+
+bool EmissionTable::interpolate(double &J, double &q, const double F, const double T,
+        const double R, const double tol) const
+{
+    if (empty() || F < Fmin || F > Fmax || T < Tmin || T > Tmax)
+        return false;
+
+    // coordinates of the point in grid units; radius is limited to the table range
+    double x = log(F / Fmin) / log(Fmax / Fmin) * (nF - 1);
+    double y = (T - Tmin) / (Tmax - Tmin) * (nT - 1);
+    double z = log(max(Rmin, min(Rmax, R)) / Rmin) / log(Rmax / Rmin) * (nR - 1);
+
+    const int i = min(int(x), nF - 2);
+    const int j = min(int(y), nT - 2);
+    const int k = min(int(z), nR - 2);
+
+    if (!(error[(i * (nT - 1) + j) * (nR - 1) + k] <= tol))
+        return false;
+
+    x -= i; y -= j; z -= k;
+    double log_J_interp = 0, q_interp = 0;
+    for (int c = 0; c < 8; ++c) {
+        const int di = c & 1, dj = (c >> 1) & 1, dk = (c >> 2) & 1;
+        const double w = (di ? x : 1 - x) * (dj ? y : 1 - y) * (dk ? z : 1 - z);
+        const int n = node(i + di, j + dj, k + dk);
+        log_J_interp += w * log_J[n];
+        q_interp += w * heat[n];
+    }
+
+    J = exp(log_J_interp);
+    q = q_interp;
+    return true;
+}
+
+double EmissionTable::barrier_radius(const double F, const vector<double> &rline, const vector<double> &Vline) {
+    const double r = rline.back();
+    const double V = Vline.back();
+
+    // potential of flat surface or above it corresponds to infinite radius
+    if (F * r - V <= 0)
+        return Rmax;
+    return r * V / (F * r - V);
+}
+
+void EmissionTable::write(const string &file_name) const {
+    ofstream out(file_name, ios::binary);
+    if (!out) {
+        write_verbose_msg("Can't write emission table to " + file_name);
+        return;
+    }
+
+    const int dims[3] = {nF, nT, nR};
+    const double params[7] = {work_function, Fmin, Fmax, Tmin, Tmax, Rmin, Rmax};
+    out.write((char*)dims, sizeof(dims));
+    out.write((char*)params, sizeof(params));
+    out.write((char*)&log_J[0], log_J.size() * sizeof(double));
+    out.write((char*)&heat[0], heat.size() * sizeof(double));
+    out.write((char*)&error[0], error.size() * sizeof(double));
+}
+
+bool EmissionTable::read(const string &file_name) {
+    ifstream in(file_name, ios::binary);
+    if (!in) return false;
+
+    int dims[3];
+    double params[7];
+    in.read((char*)dims, sizeof(dims));
+    in.read((char*)params, sizeof(params));
+    if (!in || dims[0] != nF || dims[1] != nT || dims[2] != nR || params[0] != work_function
+            || params[1] != Fmin || params[2] != Fmax || params[3] != Tmin || params[4] != Tmax
+            || params[5] != Rmin || params[6] != Rmax)
+        return false;
+
+    log_J.resize(nF * nT * nR);
+    heat.resize(nF * nT * nR);
+    error.resize((nF - 1) * (nT - 1) * (nR - 1));
+    in.read((char*)&log_J[0], log_J.size() * sizeof(double));
+    in.read((char*)&heat[0], heat.size() * sizeof(double));
+    in.read((char*)&error[0], error.size() * sizeof(double));
+
+    if (!in) {
+        log_J.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace femocs
@@ -47,6 +47,7 @@ void Interpolator::initialize(const TetgenMesh* m, double empty_val, int search_
 
     lintet.narrow_search_to(search_region);
     empty_value = empty_val;
+    basis.clear();
 
     const int n_nodes = nodes.size();
     const int n_hexs = mesh->hexs.size();
@@ -204,6 +205,28 @@ void Interpolator::extract_solution_old(PoissonSolver<3>& fem, const bool smooth
     if (smoothen) average_nodal_fields(true);
 }
 
+void Interpolator::superpose_basis(const vector<double> &coefficients) {
+    require(coefficients.size() == basis.size(), "Mismatch between # coefficients and bases: "
+            + d2s(coefficients.size()) + " vs " + d2s(basis.size()));
+
+    const int n_nodes = nodes.size();
+    for (const vector<Solution> &b : basis)
+        require(b.size() == n_nodes, "Mismatch between basis and mesh sizes: "
+                + d2s(b.size()) + " vs " + d2s(n_nodes));
+
+    for (int i = 0; i < n_nodes; ++i) {
+        if (nodes.femocs2deal(i) < 0) continue;
+        Solution sol(Vec3(0), 0, 0);
+        for (unsigned int j = 0; j < basis.size(); ++j) {
+            const Solution &b = basis[j][i];
+            sol.vector += b.vector * coefficients[j];
+            sol.norm += b.norm * coefficients[j];
+            sol.scalar += b.scalar * coefficients[j];
+        }
+        nodes.set_solution(i, sol);
+    }
+}
+
 void Interpolator::extract_solution(CurrentHeatSolver<3>& fem) {
     // Read data from FEM solver
     vector<double> potentials, temperatures;
@@ -379,6 +379,37 @@ Solution InterpolatorCells<dim>::interp_solution(const Point3 &point, const int
     return Solution(vector_i, vector_norm_i, scalar_i);
 }
 
+template<int dim>
+void InterpolatorCells<dim>::interp_weights(vector<int> &node_indices, vector<double> &weights,
+        const Point3 &point, const int c) const
+{
+    const int cell = abs(c);
+    require(cell < size(), "Index out of bounds: " + d2s(cell));
+
+    array<double,dim> sf = shape_functions(Vec3(point), cell);
+    SimpleCell<dim> scell = get_cell(cell);
+
+    node_indices.resize(dim);
+    weights.resize(dim);
+    for (int i = 0; i < dim; ++i) {
+        node_indices[i] = scell[i];
+        weights[i] = sf[i];
+    }
+}
+
+template<int dim>
+void InterpolatorCells<dim>::centroid_weights(vector<int> &node_indices, vector<double> &weights,
+        const int cell) const
+{
+    require(cell >= 0 && cell < size(), "Index out of bounds: " + d2s(cell));
+    SimpleCell<dim> scell = get_cell(cell);
+
+    node_indices.resize(dim);
+    weights.assign(dim, 1.0 / dim);
+    for (int i = 0; i < dim; ++i)
+        node_indices[i] = scell[i];
+}
+
 template<int dim>
 Solution InterpolatorCells<dim>::interp_solution_v2(const Point3 &point, const int c) const {
     const int cell = abs(c);
@@ -518,6 +549,7 @@ void LinearTetrahedra::reserve(const int N) {
     det3.clear(); det3.reserve(N);
     det4.clear(); det4.reserve(N);
     tet_not_valid.clear(); tet_not_valid.reserve(N);
+    face_neighbours.clear(); face_neighbours.reserve(N);
 }
 
 void LinearTetrahedra::precompute() {
@@ -549,6 +581,7 @@ void LinearTetrahedra::precompute() {
         for (int nbor : nnbors)
             if (nbor >= 0)
                 neighbours[tet].push_back(nbor);
+        face_neighbours.push_back({nnbors[0], nnbors[1], nnbors[2], nnbors[3]});
 
         // store next nearest neighbours of tetrahedron
         for (int node : selem)
@@ -739,6 +772,121 @@ void LinearTetrahedra::narrow_search_to(const int region) {
         markers = vector<int>(n_cells);
     } else
         require(false, "Unimplemented region: " + d2s(region));
+
+    build_search_grid();
+}
+
+void LinearTetrahedra::build_search_grid() {
+    const int n_cells = size();
+
+    // find the extent of searchable region
+    Point3 pmin(1e100), pmax(-1e100);
+    int n_searchable = 0;
+    for (int i = 0; i < n_cells; ++i) {
+        if (markers[i] != 0) continue;
+        n_searchable++;
+        for (int node : get_cell(i)) {
+            Point3 p = mesh->nodes[node];
+            pmin.x = min(pmin.x, p.x); pmax.x = max(pmax.x, p.x);
+            pmin.y = min(pmin.y, p.y); pmax.y = max(pmax.y, p.y);
+            pmin.z = min(pmin.z, p.z); pmax.z = max(pmax.z, p.z);
+        }
+    }
+
+    grid.starts.clear();
+    grid.cells.clear();
+    grid.size = {0, 0, 0};
+    if (n_searchable == 0) return;
+
+    // choose bucket size so that on average there are ~8 tetrahedra per bucket
+    Vec3 extent(pmax.x - pmin.x, pmax.y - pmin.y, pmax.z - pmin.z);
+    grid.origin = pmin;
+    grid.step = 2.0 * cbrt(extent.x * extent.y * extent.z / n_searchable);
+    if (grid.step < zero)
+        grid.step = max(extent.x, max(extent.y, extent.z)) + zero;
+    for (int i = 0; i < 3; ++i)
+        grid.size[i] = max(1, (int) ceil(extent[i] / grid.step));
+
+    // find the range of buckets overlapping with the bounding box of tetrahedron
+    auto get_range = [this](const int tet, array<int,3> &lo, array<int,3> &hi) {
+        Point3 bmin(1e100), bmax(-1e100);
+        for (int node : get_cell(tet)) {
+            Point3 p = mesh->nodes[node];
+            bmin.x = min(bmin.x, p.x); bmax.x = max(bmax.x, p.x);
+            bmin.y = min(bmin.y, p.y); bmax.y = max(bmax.y, p.y);
+            bmin.z = min(bmin.z, p.z); bmax.z = max(bmax.z, p.z);
+        }
+        lo = {get_bucket(bmin.x, grid.origin.x, grid.size[0]),
+              get_bucket(bmin.y, grid.origin.y, grid.size[1]),
+              get_bucket(bmin.z, grid.origin.z, grid.size[2])};
+        hi = {get_bucket(bmax.x, grid.origin.x, grid.size[0]),
+              get_bucket(bmax.y, grid.origin.y, grid.size[1]),
+              get_bucket(bmax.z, grid.origin.z, grid.size[2])};
+    };
+
+    // count the tetrahedra in each bucket and transform counts into offsets
+    const int n_buckets = grid.size[0] * grid.size[1] * grid.size[2];
+    grid.starts = vector<int>(n_buckets + 1, 0);
+    array<int,3> lo, hi;
+
+    for (int tet = 0; tet < n_cells; ++tet) {
+        if (markers[tet] != 0) continue;
+        get_range(tet, lo, hi);
+        for (int k = lo[2]; k <= hi[2]; ++k)
+            for (int j = lo[1]; j <= hi[1]; ++j)
+                for (int i = lo[0]; i <= hi[0]; ++i)
+                    grid.starts[1 + i + grid.size[0] * (j + grid.size[1] * k)]++;
+    }
+    for (int i = 0; i < n_buckets; ++i)
+        grid.starts[i+1] += grid.starts[i];
+
+    // distribute the tetrahedra between the buckets
+    vector<int> offsets(grid.starts.begin(), grid.starts.end() - 1);
+    grid.cells.resize(grid.starts[n_buckets]);
+    for (int tet = 0; tet < n_cells; ++tet) {
+        if (markers[tet] != 0) continue;
+        get_range(tet, lo, hi);
+        for (int k = lo[2]; k <= hi[2]; ++k)
+            for (int j = lo[1]; j <= hi[1]; ++j)
+                for (int i = lo[0]; i <= hi[0]; ++i)
+                    grid.cells[offsets[i + grid.size[0] * (j + grid.size[1] * k)]++] = tet;
+    }
+}
+
+int LinearTetrahedra::walk_to_cell(const Point3 &point, const int cell_guess, int &n_slow) const {
+    require(cell_guess < size(), "Index out of bounds: " + d2s(cell_guess));
+
+    // === Walk towards the point by crossing the face,
+    // whose opposite node has the most negative barycentric coordinate
+    int tet = cell_guess;
+    for (int step = 0; step < n_walk_steps; ++step) {
+        if (tet < 0 || markers[tet] != 0) break;
+
+        array<double,4> bcc = shape_functions(point, tet);
+        int min_node = 0;
+        for (int i = 1; i < 4; ++i)
+            if (bcc[i] < bcc[min_node]) min_node = i;
+
+        // all bcc-s are >= 0, so point is inside the tetrahedron
+        if (bcc[min_node] >= 0) return tet;
+        tet = face_neighbours[tet][min_node];
+    }
+
+    // === In case of no success, check the tetrahedra in the bucket of the point
+    n_slow++;
+    if (grid.starts.empty()) return -1;
+
+    const int i = get_bucket(point.x, grid.origin.x, grid.size[0]);
+    const int j = get_bucket(point.y, grid.origin.y, grid.size[1]);
+    const int k = get_bucket(point.z, grid.origin.z, grid.size[2]);
+    const int bucket = i + grid.size[0] * (j + grid.size[1] * k);
+
+    for (int b = grid.starts[bucket]; b < grid.starts[bucket+1]; ++b)
+        if (point_in_cell(point, grid.cells[b]))
+            return grid.cells[b];
+
+    // point is outside the searchable region
+    return -1;
 }
 
 /* ==================================================================
@@ -1561,6 +1709,20 @@ int LinearHexahedra::locate_cell(const Point3 &point, const int cell_guess) cons
     return -1;
 }
 
+int LinearHexahedra::walk_to_cell(const Point3 &point, const int cell_guess, int &n_slow) const {
+    int tet = lintet->walk_to_cell(point, max(0, cell_guess) / n_hexs_per_tet, n_slow);
+    if (tet < 0) return -1;
+
+    // calculate barycentric coordinates for a point and
+    // pick the hex that is connected to the tetrahedral node with the largest bcc
+    array<double,4> bcc = lintet->shape_functions(point, tet);
+    int max_node = 0;
+    for (int i = 1; i < 4; ++i)
+        if (bcc[i] > bcc[max_node]) max_node = i;
+
+    return n_hexs_per_tet * tet + max_node;
+}
+
 /* ==================================================================
  *  ======================= LinearTriangles ========================
  * ================================================================== */
@@ -1659,7 +1821,7 @@ array<double,3> LinearTriangles::shape_functions(const Vec3& point, const int fa
     return {zero + u, zero + v, zero + w};
 }
 
-Solution LinearTriangles::interp_solution(const Point3 &point, const int t) const {
+int LinearTriangles::locate_tet(const Point3 &point, const int t) const {
     require(mesh->tets.size() == lintet->size(),
             "Mismatch between tetrahedral mesh and interpolator sizes (" + d2s(mesh->tets.size()) + " vs " + d2s(lintet->size())
             + ")\nindicates, that LinearTetrahedra are not properly pre-computed!");
@@ -1674,15 +1836,24 @@ Solution LinearTriangles::interp_solution(const Point3 &point, const int t) cons
     // either of the cells are fine
     double distance_to_tri = abs(fast_distance(point, tri));
     if (distance_to_tri <= 100.0 * zero)
-        return lintet->interp_solution(point, tets[0]);
+        return tets[0];
 
     // test if point is inside the cell directly connected to face
     if (lintet->point_in_cell(point, tets[0]))
-        return lintet->interp_solution(point, tets[0]);
+        return tets[0];
 
     // no, use tetrahedral tools to obtain the result
-    int tet = lintet->locate_cell(point, tets[1]);
-    return lintet->interp_solution(point, tet);
+    return lintet->locate_cell(point, tets[1]);
+}
+
+Solution LinearTriangles::interp_solution(const Point3 &point, const int t) const {
+    return lintet->interp_solution(point, locate_tet(point, t));
+}
+
+void LinearTriangles::interp_weights(vector<int> &node_indices, vector<double> &weights,
+        const Point3 &point, const int t) const
+{
+    lintet->interp_weights(node_indices, weights, point, locate_tet(point, t));
 }
 
 void LinearTriangles::interp_conserved(vector<double>& scalars, const vector<Atom>& atoms) const {
@@ -1835,7 +2006,7 @@ array<double,6> QuadraticTriangles::shape_functions(const Vec3& point, const int
 //    return {u, v, w, 0, 0, 0};
 }
 
-Solution QuadraticTriangles::interp_solution(const Point3 &point, const int t) const {
+int QuadraticTriangles::locate_tet(const Point3 &point, const int t) const {
     require(tris->size() == lintri->size(),
             "Mismatch between triangular mesh and interpolator sizes (" + d2s(tris->size()) + " vs " + d2s(lintri->size())
             + ")\nindicates, that LinearTriangles are not properly pre-computed!");
@@ -1850,15 +2021,24 @@ Solution QuadraticTriangles::interp_solution(const Point3 &point, const int t) c
     // either of the cells are fine
     double distance_to_tri = abs(lintri->fast_distance(point, tri));
     if (distance_to_tri <= 100.0 * zero)
-        return quadtet->interp_solution(point, tets[0]);
+        return tets[0];
 
     // test if point is inside the cell directly connected to face
     if (quadtet->point_in_cell(point, tets[0]))
-        return quadtet->interp_solution(point, tets[0]);
+        return tets[0];
 
     // no, use tetrahedral tools to obtain the result
-    int tet = quadtet->locate_cell(point, tets[1]);
-    return quadtet->interp_solution(point, tet);
+    return quadtet->locate_cell(point, tets[1]);
+}
+
+Solution QuadraticTriangles::interp_solution(const Point3 &point, const int t) const {
+    return quadtet->interp_solution(point, locate_tet(point, t));
+}
+
+void QuadraticTriangles::interp_weights(vector<int> &node_indices, vector<double> &weights,
+        const Point3 &point, const int t) const
+{
+    quadtet->interp_weights(node_indices, weights, point, locate_tet(point, t));
 }
 
 SimpleCell<6> QuadraticTriangles::calc_cell(const int tri) const {
@@ -1919,7 +2099,7 @@ void LinearQuadrangles::precompute() {
     }
 }
 
-Solution LinearQuadrangles::interp_solution(const Point3 &point, const int q) const {
+int LinearQuadrangles::locate_hex(const Point3 &point, const int q) const {
     int quad = abs(q);
     array<int, 2> hexs = quads->to_hexs(quad);
 
@@ -1928,15 +2108,24 @@ Solution LinearQuadrangles::interp_solution(const Point3 &point, const int q) co
     // if the point is exactly inside the face, 3D cell locator doesn't work
     double distance_to_tri = abs( lintri->fast_distance(point, mesh->quads.to_tri(quad)) );
     if (distance_to_tri <= 100.0 * zero)
-        return linhex->interp_solution(point, hexs[0]);
+        return hexs[0];
 
     // test if point is inside the 3D cell that is associated with the face
     if (linhex->point_in_cell(point, hexs[0]))
-        return linhex->interp_solution(point, hexs[0]);
+        return hexs[0];
 
     // no, use hexahedral tools to obtain the result
-    int hex = linhex->locate_cell(point, hexs[1]);
-    return linhex->interp_solution(point, hex);
+    return linhex->locate_cell(point, hexs[1]);
+}
+
+Solution LinearQuadrangles::interp_solution(const Point3 &point, const int q) const {
+    return linhex->interp_solution(point, locate_hex(point, q));
+}
+
+void LinearQuadrangles::interp_weights(vector<int> &node_indices, vector<double> &weights,
+        const Point3 &point, const int q) const
+{
+    linhex->interp_weights(node_indices, weights, point, locate_hex(point, q));
 }
 
 bool LinearQuadrangles::point_in_cell(const Vec3 &point, const int cell) const {
@@ -0,0 +1,148 @@
+/*
+ * LaplaceOperator.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/fe/mapping_q1.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include "LaplaceOperator.h"
+#include "Macros.h"
+
+using namespace dealii;
+using namespace std;
+
+namespace femocs {
+
+template<int dim>
+void LaplaceOperator<dim>::initialize(const DoFHandler<dim> &dof_handler,
+        const map<types::global_dof_index, double> &boundary_values)
+{
+    constraints.clear();
+    for (auto const &bv : boundary_values)
+        constraints.add_line(bv.first);
+    constraints.close();
+
+    typename MatrixFree<dim, double>::AdditionalData additional_data;
+    additional_data.tasks_parallel_scheme = MatrixFree<dim, double>::AdditionalData::partition_color;
+    additional_data.mapping_update_flags = update_gradients | update_JxW_values;
+
+    data.reinit(StaticMappingQ1<dim>::mapping, dof_handler, constraints,
+            QGauss<1>(fe_degree + 1), additional_data);
+
+    // calculate the diagonal; the rows of constrained dofs are identity
+    Vector<double> diagonal(dof_handler.n_dofs());
+    unsigned int dummy = 0;
+    data.cell_loop(&LaplaceOperator::local_diagonal, this, diagonal, dummy);
+
+    inv_diag.reinit(dof_handler.n_dofs());
+    for (unsigned int i = 0; i < inv_diag.size(); ++i)
+        inv_diag(i) = diagonal(i) > 0 ? 1.0 / diagonal(i) : 1.0;
+    for (unsigned int i : data.get_constrained_dofs())
+        inv_diag(i) = 1.0;
+}
+
+template<int dim>
+void LaplaceOperator<dim>::clear() {
+    data.clear();
+    constraints.clear();
+    inv_diag.reinit(0);
+}
+
+template<int dim>
+double LaplaceOperator<dim>::el(const unsigned int i, const unsigned int j) const {
+    require(i == j, "Only diagonal of matrix-free operator can be accessed!");
+    return 1.0 / inv_diag(i);
+}
+
+template<int dim>
+void LaplaceOperator<dim>::vmult(Vector<double> &dst, const Vector<double> &src) const {
+    dst = 0;
+    data.cell_loop(&LaplaceOperator::local_apply, this, dst, src);
+    for (unsigned int i : data.get_constrained_dofs())
+        dst(i) = src(i);
+}
+
+template<int dim>
+void LaplaceOperator<dim>::apply_lifting(Vector<double> &rhs,
+        const map<types::global_dof_index, double> &boundary_values) const
+{
+    Vector<double> lifting(rhs.size());
+    for (auto const &bv : boundary_values)
+        lifting(bv.first) = bv.second;
+
+    // distributing into global vector skips the constrained dofs
+    Vector<double> A_lifting(rhs.size());
+    data.cell_loop(&LaplaceOperator::local_apply_plain, this, A_lifting, lifting);
+
+    rhs -= A_lifting;
+    for (auto const &bv : boundary_values)
+        rhs(bv.first) = 0;
+}
+
+template<int dim>
+void LaplaceOperator<dim>::local_apply(const MatrixFree<dim, double> &data, Vector<double> &dst,
+        const Vector<double> &src, const pair<unsigned int, unsigned int> &cell_range) const
+{
+    FEEvaluation<dim, fe_degree> phi(data);
+    for (unsigned int cell = cell_range.first; cell < cell_range.second; ++cell) {
+        phi.reinit(cell);
+        phi.read_dof_values(src);
+        phi.evaluate(false, true);
+        for (unsigned int q = 0; q < phi.n_q_points; ++q)
+            phi.submit_gradient(phi.get_gradient(q), q);
+        phi.integrate(false, true);
+        phi.distribute_local_to_global(dst);
+    }
+}
+
+template<int dim>
+void LaplaceOperator<dim>::local_apply_plain(const MatrixFree<dim, double> &data, Vector<double> &dst,
+        const Vector<double> &src, const pair<unsigned int, unsigned int> &cell_range) const
+{
+    FEEvaluation<dim, fe_degree> phi(data);
+    for (unsigned int cell = cell_range.first; cell < cell_range.second; ++cell) {
+        phi.reinit(cell);
+        phi.read_dof_values_plain(src);
+        phi.evaluate(false, true);
+        for (unsigned int q = 0; q < phi.n_q_points; ++q)
+            phi.submit_gradient(phi.get_gradient(q), q);
+        phi.integrate(false, true);
+        phi.distribute_local_to_global(dst);
+    }
+}
+
+template<int dim>
+void LaplaceOperator<dim>::local_diagonal(const MatrixFree<dim, double> &data, Vector<double> &dst,
+        const unsigned int &, const pair<unsigned int, unsigned int> &cell_range) const
+{
+    FEEvaluation<dim, fe_degree> phi(data);
+    AlignedVector<VectorizedArray<double>> diagonal(phi.dofs_per_cell);
+
+    for (unsigned int cell = cell_range.first; cell < cell_range.second; ++cell) {
+        phi.reinit(cell);
+
+        // apply the cell operator to unit vectors and pick the diagonal entries
+        for (unsigned int i = 0; i < phi.dofs_per_cell; ++i) {
+            for (unsigned int j = 0; j < phi.dofs_per_cell; ++j)
+                phi.submit_dof_value(make_vectorized_array(0.0), j);
+            phi.submit_dof_value(make_vectorized_array(1.0), i);
+
+            phi.evaluate(false, true);
+            for (unsigned int q = 0; q < phi.n_q_points; ++q)
+                phi.submit_gradient(phi.get_gradient(q), q);
+            phi.integrate(false, true);
+            diagonal[i] = phi.get_dof_value(i);
+        }
+
+        for (unsigned int i = 0; i < phi.dofs_per_cell; ++i)
+            phi.submit_dof_value(diagonal[i], i);
+        phi.distribute_local_to_global(dst);
+    }
+}
+
+template class LaplaceOperator<3> ;
+
+} // namespace femocs
@@ -7,6 +7,8 @@
 
 #include "ParticleSpecies.h"
 
+#include <omp.h>
+
 namespace femocs {
 
 ParticleSpecies::ParticleSpecies(double _q_over_m, double _q_over_eps0, double _Wsp) :
@@ -14,20 +16,114 @@ ParticleSpecies::ParticleSpecies(double _q_over_m, double _q_over_eps0, double _
 {}
 
 int ParticleSpecies::clear_lost() {
-    size_t npart = parts.size();
-    size_t nlost = 0;
-
-    // Delete the lost particles from the array
-    for (size_t i = 0; i < npart; i++) {
-        if (parts[i].cell==-1)
-            nlost++;
-        else if (nlost > 0)
-            parts[i-nlost] = parts[i];
+    const int npart = size();
+    vector<int> thread_starts(omp_get_max_threads() + 1, 0);
+    int nkept = 0;
+
+    vector<Point3> pos_kept;
+    vector<Vec3> vel_kept;
+    vector<int> cell_kept;
+    vector<double> weight_kept;
+
+    // Stable stream compaction: every thread counts the remaining particles in its chunk,
+    // prefix sum gives the location of the chunk in the compacted arrays
+#pragma omp parallel
+    {
+        const int thread = omp_get_thread_num();
+        const int n_threads = omp_get_num_threads();
+        const int begin = (long) npart * thread / n_threads;
+        const int end = (long) npart * (thread + 1) / n_threads;
+
+        int n = 0;
+        for (int i = begin; i < end; ++i)
+            n += cell[i] != -1;
+        thread_starts[thread+1] = n;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            for (int i = 0; i < n_threads; ++i)
+                thread_starts[i+1] += thread_starts[i];
+            nkept = thread_starts[n_threads];
+
+            if (nkept < npart) {
+                pos_kept.resize(nkept);
+                vel_kept.resize(nkept);
+                cell_kept.resize(nkept);
+                weight_kept.resize(nkept);
+            }
+        }
+
+        // Copy the remaining particles into new arrays
+        if (nkept < npart) {
+            int j = thread_starts[thread];
+            for (int i = begin; i < end; ++i) {
+                if (cell[i] == -1) continue;
+                pos_kept[j] = pos[i];
+                vel_kept[j] = vel[i];
+                cell_kept[j] = cell[i];
+                weight_kept[j] = weight[i];
+                j++;
+            }
+        }
+    }
+
+    if (nkept == npart) return 0;
+
+    pos.swap(pos_kept);
+    vel.swap(vel_kept);
+    cell.swap(cell_kept);
+    weight.swap(weight_kept);
+    return npart - nkept;
+}
+
+void ParticleSpecies::sort(const int n_cells) {
+    const int n_parts = size();
+    if (n_parts <= 1) return;
+
+    // count the particles in each cell
+    vector<int> cell_start(n_cells + 1, 0);
+    for (int c : cell) {
+        require(c >= 0 && c < n_cells, "Invalid cell: " + d2s(c));
+        cell_start[c+1]++;
+    }
+
+    // transform the counts into the index of the first particle in a cell
+    for (int i = 0; i < n_cells; ++i)
+        cell_start[i+1] += cell_start[i];
+
+    // calculate the new location of every particle (counting sort)
+    vector<int> order(n_parts);
+    for (int i = 0; i < n_parts; ++i)
+        order[cell_start[cell[i]]++] = i;
+
+    // reorder the particle data
+    vector<Point3> pos_sorted(n_parts);
+    vector<Vec3> vel_sorted(n_parts);
+    vector<int> cell_sorted(n_parts);
+    vector<double> weight_sorted(n_parts);
+    for (int i = 0; i < n_parts; ++i) {
+        const int j = order[i];
+        pos_sorted[i] = pos[j];
+        vel_sorted[i] = vel[j];
+        cell_sorted[i] = cell[j];
+        weight_sorted[i] = weight[j];
     }
 
-    // Shrink the array
-    if (nlost > 0) parts.resize(npart-nlost);
-    return nlost;
+    pos.swap(pos_sorted);
+    vel.swap(vel_sorted);
+    cell.swap(cell_sorted);
+    weight.swap(weight_sorted);
+}
+
+void ParticleSpecies::rescale_Wsp(double new_Wsp) {
+    require(new_Wsp > 0, "Invalid SP weight: " + d2s(new_Wsp));
+    if (Wsp > 0) {
+        const double factor = Wsp / new_Wsp;
+        for (double &w : weight)
+            w *= factor;
+    }
+    Wsp = new_Wsp;
 }
 
 } // namespace femocs
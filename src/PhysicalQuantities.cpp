@@ -14,6 +14,7 @@
 #include <sys/stat.h>
 
 #include "PhysicalQuantities.h"
+#include "Macros.h"
 
 
 namespace femocs {
@@ -29,46 +30,109 @@ double PhysicalQuantities::nottingham_de(double field, double temperature) const
 }
 
 double PhysicalQuantities::evaluate_resistivity(double temperature) const {
-    if (temperature < resistivity_data.front().first)
-        temperature = resistivity_data.front().first;
-    if (temperature > resistivity_data.back().first)
-        temperature = resistivity_data.back().first;
-    return 10. * linear_interp(temperature, resistivity_data);
+    return table_value(table.rho, temperature);
 }
 
 double PhysicalQuantities::evaluate_resistivity_derivative(double temperature) const {
-    if (temperature < resistivity_data.front().first)
-        temperature = resistivity_data.front().first;
-    if (temperature > resistivity_data.back().first)
-        temperature = resistivity_data.back().first;
-    return 10. * deriv_linear_interp(temperature, resistivity_data);
+    return table_value(table.drho, temperature);
 }
 
 double PhysicalQuantities::sigma(double temperature) const {
-    double rho = evaluate_resistivity(temperature);
-    return 1.0 / rho;
+    return table_value(table.sigma, temperature);
 }
 
 double PhysicalQuantities::dsigma(double temperature) const {
-    double rho = evaluate_resistivity(temperature);
-    return -evaluate_resistivity_derivative(temperature) / (rho * rho);
+    return table_value(table.dsigma, temperature);
 }
 
 double PhysicalQuantities::kappa(double temperature) const {
-    if (temperature < resistivity_data.front().first)
-        temperature = resistivity_data.front().first;
-    if (temperature > resistivity_data.back().first)
-        temperature = resistivity_data.back().first;
-
-    return config.lorentz * temperature * sigma(temperature);
+    return table_value(table.kappa, temperature);
 }
 
 double PhysicalQuantities::dkappa(double temperature) const {
-    if (temperature < resistivity_data.front().first)
-        temperature = resistivity_data.front().first;
-    if (temperature > resistivity_data.back().first)
-        temperature = resistivity_data.back().first;
-    return config.lorentz * (sigma(temperature) + temperature * dsigma(temperature));
+    return table_value(table.dkappa, temperature);
+}
+
+void PhysicalQuantities::sigma(const std::vector<double> &temperatures, std::vector<double> &values) const {
+    table_values(table.sigma, temperatures, values);
+}
+
+void PhysicalQuantities::dsigma(const std::vector<double> &temperatures, std::vector<double> &values) const {
+    table_values(table.dsigma, temperatures, values);
+}
+
+void PhysicalQuantities::kappa(const std::vector<double> &temperatures, std::vector<double> &values) const {
+    table_values(table.kappa, temperatures, values);
+}
+
+void PhysicalQuantities::dkappa(const std::vector<double> &temperatures, std::vector<double> &values) const {
+    table_values(table.dkappa, temperatures, values);
+}
+
+void PhysicalQuantities::table_values(const std::vector<double> &values,
+        const std::vector<double> &temperatures, std::vector<double> &result) const
+{
+    const int n_values = temperatures.size();
+    result.resize(n_values);
+    for (int j = 0; j < n_values; ++j) {
+        double w;
+        const int i = table_index(temperatures[j], w);
+        result[j] = values[i] + w * (values[i+1] - values[i]);
+    }
+}
+
+void PhysicalQuantities::build_lookup_table() {
+    require(resistivity_data.size() > 0, "No resistivity data!");
+    typedef std::pair<double, double> myPair;
+    require(std::is_sorted(resistivity_data.begin(), resistivity_data.end(),
+            [](myPair lhs, myPair rhs) -> bool {return lhs.first < rhs.first;}),
+            "Resistivity data must be sorted by temperature!");
+
+    // zero-width intervals would break the interpolation, so the repeated temperatures are dropped
+    auto last = std::unique(resistivity_data.begin(), resistivity_data.end(),
+            [](myPair lhs, myPair rhs) -> bool {return lhs.first == rhs.first;});
+    if (last != resistivity_data.end()) {
+        write_silent_msg("Ignoring " + d2s(int(resistivity_data.end() - last))
+                + " resistivity data points with repeated temperature");
+        resistivity_data.erase(last, resistivity_data.end());
+    }
+
+    const int n_data = resistivity_data.size();
+    table.tmin = resistivity_data.front().first;
+    table.tmax = resistivity_data.back().first;
+
+    // single data point gives constant resistivity, which is tabulated in two equal points
+    int n_points = 2;
+    double step = 0;
+    table.inv_step = 0;
+
+    if (n_data > 1) {
+        // the grid must be fine enough to resolve every interval of the resistivity data
+        double min_interval = table.tmax - table.tmin;
+        for (int i = 1; i < n_data; ++i)
+            min_interval = std::min(min_interval, resistivity_data[i].first - resistivity_data[i-1].first);
+
+        n_points = std::max(n_table_min, 1 + int(std::ceil(4.0 * (table.tmax - table.tmin) / min_interval)));
+        step = (table.tmax - table.tmin) / (n_points - 1);
+        table.inv_step = 1.0 / step;
+    }
+
+    table.rho.resize(n_points); table.drho.resize(n_points);
+    table.sigma.resize(n_points); table.dsigma.resize(n_points);
+    table.kappa.resize(n_points); table.dkappa.resize(n_points);
+
+    for (int i = 0; i < n_points; ++i) {
+        const double T = std::min(table.tmax, table.tmin + i * step);
+        const double rho = 10. * linear_interp(T, resistivity_data);
+        const double drho = n_data > 1 ? 10. * deriv_linear_interp(T, resistivity_data) : 0;
+
+        table.rho[i] = rho;
+        table.drho[i] = drho;
+        table.sigma[i] = 1.0 / rho;
+        table.dsigma[i] = -drho / (rho * rho);
+        table.kappa[i] = config.lorentz * T * table.sigma[i];
+        table.dkappa[i] = config.lorentz * (table.sigma[i] + T * table.dsigma[i]);
+    }
 }
 
 bool PhysicalQuantities::load_spreadsheet_grid_data(std::string filepath, InterpolationGrid &grid) {
@@ -167,11 +231,12 @@ bool PhysicalQuantities::load_resistivity_data(std::string filepath) {
         resistivity_data.push_back(std::make_pair(x, y));
     }
     infile.close();
+    build_lookup_table();
     return true;
 }
 
 double PhysicalQuantities::linear_interp(double x,
-        std::vector<std::pair<double, double>> data) const {
+        const std::vector<std::pair<double, double>> &data) const {
     if (x <= data[0].first)
         return data[0].second;
     if (x >= data.back().first)
@@ -184,8 +249,8 @@ double PhysicalQuantities::linear_interp(double x,
     return it2->second + (it1->second - it2->second) * (x - it2->first) / (it1->first - it2->first);
 }
 
-double PhysicalQuantities::evaluate_derivative(std::vector<std::pair<double, double>> &data,
-        std::vector<std::pair<double, double>>::iterator it) const {
+double PhysicalQuantities::evaluate_derivative(const std::vector<std::pair<double, double>> &data,
+        std::vector<std::pair<double, double>>::const_iterator it) const {
     if (it == data.begin()) {
         return ((it + 1)->second - it->second) / ((it + 1)->first - it->first);
     } else if (it == data.end() - 1) {
@@ -237,7 +302,7 @@ void PhysicalQuantities::output_to_files() const {
 /**
  * NB: Derivative is extrapolated by boundary values; out of bounds the real derivative should be zero!
  */
-double PhysicalQuantities::deriv_linear_interp(double x, std::vector<std::pair<double, double>> data) const {
+double PhysicalQuantities::deriv_linear_interp(double x, const std::vector<std::pair<double, double>> &data) const {
     double eps = 1e-10;
     if (x <= data[0].first)
         x = data[0].first + eps;
@@ -25,6 +25,7 @@ void PhysicalQuantities::initialize_with_hc_data() {
         write_silent_msg("Resistivity file " + config.rhofile + " not found! Using resistivities of bulk Cu.");
         resistivity_data = hc_resistivity_data;
     }
+    build_lookup_table();
 
     emission_grid.v = hc_emission_current_data;
     emission_grid.xmin = -9.21034037;
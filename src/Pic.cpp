@@ -10,6 +10,7 @@
 
 #include <deal.II/base/tensor.h>
 #include <deal.II/base/point.h>
+#include <algorithm>
 
 using namespace std;
 namespace femocs {
@@ -17,85 +18,112 @@ namespace femocs {
 template<int dim>
 Pic<dim>::Pic(const PoissonSolver<dim> *poisson, const EmissionReader *er,
         const Interpolator *i, const Config::PIC *config, const unsigned int seed) :
-        poisson_solver(poisson), emission(er), interpolator(i), conf(config),
-        electrons(-e_over_me, -e_over_eps0, 0),
-        mersenne{seed}
+        poisson_solver(poisson), emission(er), interpolator(i), conf(config), seed(seed),
+        electrons(-e_over_me, -e_over_eps0, 0)
 {}
 
 template<int dim>
 int Pic<dim>::inject_electrons(const bool fractional_push) {
-    vector<Point3> positions;
-    vector<int> cells;
-    inject_electrons(positions, cells, *emission->mesh);
-
-    if (positions.size() > conf->max_injected)
-        return -1 * positions.size();
-
-    Vec3 velocity(0);
-
-    for (unsigned int i = 0; i < positions.size(); ++i) {
-        //update the field
-        int cell = interpolator->linhex.deal2femocs(cells[i]);
-        Vec3 elfield = interpolator->linhex.interp_gradient(positions[i], cell) ;
-
-        // Random fractional timestep push -- from a random point [t_(k-1),t_k] to t_k, t_(k + 1/2), using field at t_k.
-        if (fractional_push) {
-            velocity = elfield * (electrons.q_over_m * data.dt * (uniform(mersenne) + 0.5));
-            positions[i] += velocity * (data.dt * uniform(mersenne));
-        } else {
-            velocity = elfield * (electrons.q_over_m * data.dt * 0.5);
-        }
-
-        // Save to particle arrays
-        electrons.inject_particle(positions[i], velocity, cells[i]);
-    }
-
-    data.injected += positions.size();
-    return positions.size();
-}
+    const TetgenMesh &mesh = *emission->mesh;
+    const int n_faces = emission->fields->size();
+    const uint64_t step = get_stream_step(uint64_t(1) << 62);
 
-template<int dim>
-void Pic<dim>::inject_electrons(vector<Point3> &positions, vector<int> &cells, const TetgenMesh &mesh) {
+    // calculate the nr of electrons injected from each face;
+    // every face has its own random stream to make the result independent of threading
+    vector<int> face_starts(n_faces + 1, 0);
 
-    const double shift_factor = mesh.tris.stat.edgemin * 1e-6;
-    const int n_points = emission->fields->size();
+#pragma omp parallel for
+    for (int face = 0; face < n_faces; ++face) {
+        RandomStream rng(seed, step, face);
+        face_starts[face+1] = get_n_injected(face, rng);
+    }
 
-    // loop through quadrangle centroids
-    for (int i = 0; i < n_points; ++i) {
-        double current = emission->currents[i] * electrons_per_fs;
-        double charge = current * data.dt; //in e
-        double n_sps = charge / electrons.get_Wsp();
+    // transform the counts into the index of the first electron injected from the face
+    for (int face = 0; face < n_faces; ++face)
+        face_starts[face+1] += face_starts[face];
 
-        int intpart = (int) floor(n_sps);
-        double frpart = n_sps - intpart;
-        int n_electrons = intpart;
+    const int n_injected = face_starts[n_faces];
+    if (n_injected > (int)conf->max_injected)
+        return -1 * n_injected;
 
-        if (uniform(mersenne) < frpart)
-            n_electrons++;
+    const int n_old = electrons.size();
+    electrons.resize(n_old + n_injected);
 
+    const double shift_factor = mesh.tris.stat.edgemin * 1e-6;
+    const double dt_prev = get_dt_prev();
+    const double kick_factor = electrons.q_over_m * data.dt;
+    const double prev_factor = electrons.q_over_m * dt_prev;
+    const double push_factor = electrons.q_over_m * 0.5 * (dt_prev + data.dt);
+
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int face = 0; face < n_faces; ++face) {
+        const int n_electrons = face_starts[face+1] - face_starts[face];
         if (n_electrons == 0) continue;
 
-        int quad = abs(emission->fields->get_marker(i));
+        // repeat the draw of the first pass to continue in the same stream
+        RandomStream rng(seed, step, face);
+        get_n_injected(face, rng);
+        uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        int quad = abs(emission->fields->get_marker(face));
         int tri = mesh.quads.to_tri(quad);
         int hex = mesh.quad2hex(quad, TYPES.VACUUM);
-
-        hex = interpolator->linhex.femocs2deal(hex);
+        int deal_hex = interpolator->linhex.femocs2deal(hex);
         Vec3 shift = mesh.tris.get_norm(tri) * shift_factor;
 
         // generate desired amount of electrons
         // that are uniformly distributed on a given quadrangle
         for (int j = 0; j < n_electrons; ++j) {
-            Point3 position = get_rnd_point(quad, mesh);
+            const int i = n_old + face_starts[face] + j;
+
             // push point little bit inside the vacuum mesh
+            Point3 position = get_rnd_point(quad, mesh, rng);
             position += shift;
-            positions.push_back(position);
-            cells.push_back(hex);
+
+            //update the field
+            Vec3 elfield = interpolator->linhex.interp_gradient(position, hex);
+            Vec3 velocity;
+
+            // Random fractional timestep push -- from a random point [t_(k-1),t_k] to t_k, t_(k + 1/2), using field at t_k.
+            // The velocity is stored one kick behind, as the next push_particles call
+            // adds the kick over (dt_prev + dt) / 2 with the same field.
+            if (fractional_push) {
+                velocity = elfield * (prev_factor * uniform(rng) + kick_factor * 0.5);
+                position += velocity * (dt_prev * uniform(rng));
+                velocity -= elfield * push_factor;
+            } else {
+                velocity = elfield * (prev_factor * -0.5);
+            }
+
+            // Save to particle arrays
+            electrons.pos[i] = position;
+            electrons.vel[i] = velocity;
+            electrons.cell[i] = deal_hex;
+            electrons.weight[i] = 1.0;
         }
     }
+
+    data.injected += n_injected;
+    return n_injected;
 }
 
 template<int dim>
-Point3 Pic<dim>::get_rnd_point(const int quad, const TetgenMesh &mesh) {
+int Pic<dim>::get_n_injected(const int face, RandomStream &rng) const {
+    double current = emission->currents[face] * electrons_per_fs;
+    double charge = current * data.dt; //in e
+    double n_sps = charge / electrons.get_Wsp();
+
+    int intpart = (int) floor(n_sps);
+    double frpart = n_sps - intpart;
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    if (uniform(rng) < frpart)
+        return intpart + 1;
+    return intpart;
+}
+
+template<int dim>
+Point3 Pic<dim>::get_rnd_point(const int quad, const TetgenMesh &mesh, RandomStream &rng) const {
     const int tri = mesh.quads.to_tri(quad);
     const int section = quad % n_quads_per_tri;
 
@@ -114,12 +142,13 @@ Point3 Pic<dim>::get_rnd_point(const int quad, const TetgenMesh &mesh) {
     Vec3 edge2 = (mesh.nodes.get_vec(sface[k]) - node0) * 0.5;
 
     array<double,3> bcc;
+    uniform_real_distribution<double> uniform(0.0, 1.0);
 
     // loop until desired point is found
     for (int safe_cntr = 0; safe_cntr < 100; ++safe_cntr) {
         // Generate random point inside parallelogram composed of edge1 & edge2
-        double rand1 = uniform(mersenne);
-        double rand2 = uniform(mersenne);
+        double rand1 = uniform(rng);
+        double rand2 = uniform(rng);
         Point3 point = node0 + edge1 * rand1 + edge2 * rand2;
 
         // calculate barycentric coordinates for a point
@@ -135,39 +164,99 @@ Point3 Pic<dim>::get_rnd_point(const int quad, const TetgenMesh &mesh) {
 }
 
 template<int dim>
-int Pic<dim>::update_positions() {
+int Pic<dim>::push_particles() {
+    const LinearHexahedra &linhex = interpolator->linhex;
+    const int n_electrons = electrons.size();
+    // with variable timestep the velocity is kicked from t_(k-1/2) to t_(k+1/2)
+    const double kick_factor = 0.5 * (get_dt_prev() + data.dt) * electrons.q_over_m;
+    data.n_slow_locates = 0;
+
+#pragma omp parallel
+    {
+        array<double,n_nodes_per_hex> potentials;
+        int prev_cell = -1;
+        int femocs_cell = -1;
+        int n_slow = 0;
+
+        // as particles are sorted by cells, static scheduling gives
+        // every thread a contiguous block of cells to work with
+#pragma omp for schedule(static)
+        for (int i = 0; i < n_electrons; ++i) {
+            // gather the nodal potentials only once per cell
+            if (electrons.cell[i] != prev_cell) {
+                prev_cell = electrons.cell[i];
+                femocs_cell = linhex.deal2femocs(prev_cell);
+                SimpleCell<n_nodes_per_hex> shex = linhex.get_cell(femocs_cell);
+                for (int j = 0; j < n_nodes_per_hex; ++j)
+                    potentials[j] = interpolator->nodes.get_scalar(shex[j]);
+            }
 
-#pragma omp parallel for
-    for  (int i = 0; i < electrons.size(); ++i)
-        // positions are updated in separate routine to make it easier
-        // to parallelize the process with OpenMP
-        update_position(i);
+            // find electric field
+            array<Vec3,n_nodes_per_hex> sfg = linhex.shape_fun_grads(electrons.pos[i], femocs_cell);
+            Vec3 elfield(0);
+            for (int j = 0; j < n_nodes_per_hex; ++j)
+                elfield -= sfg[j] * potentials[j];
+
+            // update velocity (corresponds to t + .5dt)
+            electrons.vel[i] += elfield * kick_factor;
+
+            // update position & cell
+            update_position(i, n_slow);
+        }
 
+#pragma omp atomic
+        data.n_slow_locates += n_slow;
+    }
+
+    data.dt_prev = data.dt;
+    data.n_pushes++;
     int n_lost_particles = electrons.clear_lost();
 
+    // periodically sort particles by cells to improve the data locality
+    if (conf->sort_period > 0 && data.n_pushes % conf->sort_period == 0)
+        electrons.sort(poisson_solver->get_n_cells());
+
     data.removed += n_lost_particles;
     return n_lost_particles;
 }
 
 template<int dim>
-void Pic<dim>::update_position(const int particle_index) {
-    SuperParticle &electron = electrons[particle_index];
+int Pic<dim>::update_cells() {
+    const int n_electrons = electrons.size();
+    int n_slow = 0;
+
+#pragma omp parallel for reduction(+:n_slow)
+    for (int i = 0; i < n_electrons; ++i)
+        electrons.cell[i] = update_point_cell(electrons.pos[i], electrons.cell[i], n_slow);
+
+    data.n_slow_locates = n_slow;
+
+    int n_lost_particles = electrons.clear_lost();
+    electrons.sort(poisson_solver->get_n_cells());
+
+    data.removed += n_lost_particles;
+    return n_lost_particles;
+}
+
+template<int dim>
+void Pic<dim>::update_position(const int particle_index, int &n_slow) {
+    Point3 &pos = electrons.pos[particle_index];
 
     //update position
-    electron.pos += electron.vel * data.dt;
+    pos += electrons.vel[particle_index] * data.dt;
 
     bool b1 = true;
     bool b2 = true;
-    bool b3 = electron.pos.z < data.box.zmax;
+    bool b3 = pos.z < data.box.zmax;
 
     if (conf->periodic) {
         // apply periodic boundaries
-        electron.pos.x = periodic_image(electron.pos.x, data.box.xmax, data.box.xmin);
-        electron.pos.y = periodic_image(electron.pos.y, data.box.ymax, data.box.ymin);
+        pos.x = periodic_image(pos.x, data.box.xmax, data.box.xmin);
+        pos.y = periodic_image(pos.y, data.box.ymax, data.box.ymin);
     } else {
         // check the boundaries in x,y-direction
-        b1 = electron.pos.x > data.box.xmin && electron.pos.x < data.box.xmax;
-        b2 = electron.pos.y > data.box.ymin && electron.pos.y < data.box.ymax;
+        b1 = pos.x > data.box.xmin && pos.x < data.box.xmax;
+        b2 = pos.y > data.box.ymin && pos.y < data.box.ymax;
         if (!b1 || !b2) {
             write_silent_msg("Electron " + d2s(particle_index) + " crossed "
                     "simubox x or y boundary and will be deleted.\n  "
@@ -177,37 +266,25 @@ void Pic<dim>::update_position(const int particle_index) {
 
     // Update the cell ID; if any particles have left the domain their ID is set to -1
     // and they will be removed once we call clear_lost
+    int &cell = electrons.cell[particle_index];
     if (b3 && b2 && b1)
-        electron.cell = update_point_cell(electron);
+        cell = update_point_cell(pos, cell, n_slow);
     else
-        electron.cell = -1;
+        cell = -1;
 }
 
 template<int dim>
-int Pic<dim>::update_point_cell(const SuperParticle& particle) const {
+int Pic<dim>::update_point_cell(const Point3 &pos, const int cell, int &n_slow) const {
     // in case mesh has changed, the particle.cell has quite random value w.r the new mesh.
     // However the cell nr from previous mesh is little bit better guess than just 0,
     // as there is a hope, that new mesh was generated similarly to the old one
     // and therefore also the cell indices in old and new mesh are similar although different.
-    int femocs_cell = interpolator->linhex.deal2femocs(particle.cell);
-    femocs_cell = interpolator->linhex.locate_cell(particle.pos, femocs_cell);
+    int femocs_cell = interpolator->linhex.deal2femocs(cell);
+    femocs_cell = interpolator->linhex.walk_to_cell(pos, femocs_cell, n_slow);
     if (femocs_cell < 0) return -1;
     return interpolator->linhex.femocs2deal(femocs_cell);
 }
 
-template<int dim>
-void Pic<dim>::update_velocities(){
-    for (SuperParticle &electron : electrons) {
-
-        // find electric field
-        int cell = interpolator->linhex.deal2femocs(electron.cell);
-        Vec3 elfield = interpolator->linhex.interp_gradient(electron.pos, cell);
-
-        // update velocities (corresponds to t + .5dt)
-        electron.vel += elfield * (data.dt * electrons.q_over_m);
-    }
-}
-
 /* Collide same kind of charged particles as described in
  * Takizuka and H. Abe
  * A binary collision model for plasma simulation with a particle code
@@ -219,43 +296,57 @@ void Pic<dim>::collide_particles() {
     double variance_factor = e_over_me * e_over_eps0 * electrons.get_Wsp();
     variance_factor *= variance_factor * data.dt * conf->landau_log / twopi;
 
-    vector<vector<size_t>> particles_in_cell;
-    group_and_shuffle_particles(particles_in_cell);
+    vector<int> particles, cell_starts;
+    group_particles(particles, cell_starts);
+
+    const int n_cells = cell_starts.size() - 1;
+    const uint64_t step = get_stream_step(0);
 
-    int cell = 0;
-    for (vector<size_t> &particles : particles_in_cell) {
-        size_t n_parts = particles.size();
+    // Collisions in different cells are independent. As every cell has its own random stream,
+    // the result does not depend on the nr of threads or on the scheduling.
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int cell = 0; cell < n_cells; ++cell) {
+        const int n_parts = cell_starts[cell+1] - cell_starts[cell];
         if (n_parts <= 1) continue;
 
+        RandomStream rng(seed, step, cell);
+        int* parts = &particles[cell_starts[cell]];
+
+        // nr of physical particles in the cell in the units of Wsp
+        double n_eff = 0;
+        for (int p = 0; p < n_parts; ++p)
+            n_eff += electrons.weight[parts[p]];
+
+        // Randomize the ordering of particles in a cell;
+        // no need to shuffle <= 3 particles, as their pairing doesn't change
+        if (n_parts > 3) {
+            std::uniform_int_distribution<int> rnd_int(0, n_parts-1);
+            for (int p = 0; p < n_parts; ++p)
+                std::swap(parts[p], parts[rnd_int(rng)]);
+        }
+
         // constant factor in Coulomb collisions for this cell
-        double Acoll_cell = variance_factor * n_parts / poisson_solver->get_cell_vol(cell++);
-        size_t start_p = 0;
+        double Acoll_cell = variance_factor * n_eff / poisson_solver->get_cell_vol(cell);
+        int start_p = 0;
 
         // for odd number of particles, perform first three collisions differently
         if (n_parts % 2) {
             start_p = 3;
-            size_t p1 = particles[0];
-            size_t p2 = particles[1];
-            size_t p3 = particles[2];
-
-            collide_pair(p1, p2, 0.5*Acoll_cell);
-            collide_pair(p1, p3, 0.5*Acoll_cell);
-            collide_pair(p2, p3, 0.5*Acoll_cell);
+            collide_pair(parts[0], parts[1], 0.5*Acoll_cell, rng);
+            collide_pair(parts[0], parts[2], 0.5*Acoll_cell, rng);
+            collide_pair(parts[1], parts[2], 0.5*Acoll_cell, rng);
         }
 
         // perform pair-wise collision
-        for (size_t p = start_p; p < n_parts; p+=2) {
-            size_t p1 = particles[p];
-            size_t p2 = particles[p+1];
-            collide_pair(p1, p2, Acoll_cell);
-        }
+        for (int p = start_p; p < n_parts; p+=2)
+            collide_pair(parts[p], parts[p+1], Acoll_cell, rng);
     }
 }
 
 template<int dim>
-void Pic<dim>::collide_pair(int p1, int p2, double variance_factor) {
+void Pic<dim>::collide_pair(int p1, int p2, double variance_factor, RandomStream &rng) {
     // Relative velocity
-    Vec3 v_rel = electrons[p1].vel - electrons[p2].vel;
+    Vec3 v_rel = electrons.vel[p1] - electrons.vel[p2];
     double v_rel_norm  = v_rel.norm();
 
     // If u->0, the relative change might be big,
@@ -267,8 +358,9 @@ void Pic<dim>::collide_pair(int p1, int p2, double variance_factor) {
     double variance2 = variance_factor / (v_rel_norm*v_rel_norm*v_rel_norm);
 
     std::normal_distribution<double> rnd_gauss(0.0, sqrt(variance2));
-    double delta = rnd_gauss(mersenne);     // scattering angle
-    double phi = twopi * uniform(mersenne); // azimuth angle
+    std::uniform_real_distribution<double> rnd_uniform(0.0, 1.0);
+    double delta = rnd_gauss(rng);             // scattering angle
+    double phi = twopi * rnd_uniform(rng);     // azimuth angle
 
     // Calculate rotation/scattering matrix entries
     double sin_theta = 2 * delta / (1 + delta*delta);
@@ -301,37 +393,272 @@ void Pic<dim>::collide_pair(int p1, int p2, double variance_factor) {
     }
     v_delta *= 0.5;
 
-    // Update the particle velocities (particle masses are identical)
-    electrons[p1].vel += v_delta;
-    electrons[p2].vel -= v_delta;
+    // Update the particle velocities (particle masses are identical).
+    // SP-s with unequal weights are treated as in
+    // Nanbu and Yonemura, Journal of Computational Physics 145 (1998) 639:
+    // the lighter SP is always scattered and the heavier one with the probability w_min / w_max.
+    // This conserves the momentum and energy on average.
+    const double w1 = electrons.weight[p1];
+    const double w2 = electrons.weight[p2];
+    if (w1 == w2) {
+        electrons.vel[p1] += v_delta;
+        electrons.vel[p2] -= v_delta;
+    } else if (w1 < w2) {
+        electrons.vel[p1] += v_delta;
+        if (rnd_uniform(rng) * w2 < w1) electrons.vel[p2] -= v_delta;
+    } else {
+        electrons.vel[p2] -= v_delta;
+        if (rnd_uniform(rng) * w1 < w2) electrons.vel[p1] += v_delta;
+    }
 }
 
 template<int dim>
-void Pic<dim>::group_and_shuffle_particles(vector<vector<size_t>> &parts_in_cell) {
+int Pic<dim>::control_population() {
+    const int target = conf->particles_per_cell;
+    if (target <= 0) return 0;
+
+    vector<int> particles, cell_starts;
+    group_particles(particles, cell_starts);
+
+    const int n_cells = cell_starts.size() - 1;
+    const int n_old = electrons.size();
+    const uint64_t step = get_stream_step(uint64_t(1) << 63);
+
+    // list of particles to be split in each cell together with the displacement of the copy
+    vector<vector<pair<int,Vec3>>> splits(n_cells);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int cell = 0; cell < n_cells; ++cell) {
+        const int n_parts = cell_starts[cell+1] - cell_starts[cell];
+        int* parts = &particles[cell_starts[cell]];
+
+        if (n_parts > 2 * target)
+            merge_particles(parts, n_parts, (int) ceil(2.0 * n_parts / target));
+        else if (n_parts > 0 && 2 * n_parts < target) {
+            RandomStream rng(seed, step, cell);
+            split_particles(parts, n_parts, target - n_parts, cell, rng, splits[cell]);
+        }
+    }
+
+    // append the copies of split particles in the order of cells to keep the result reproducible
+    for (int cell = 0; cell < n_cells; ++cell)
+        for (pair<int,Vec3> const &split : splits[cell]) {
+            // the original half is already moved by +d, so the copy goes to original position - d
+            const int p = split.first;
+            electrons.inject_particle(electrons.pos[p] - split.second * 2.0, electrons.vel[p],
+                    electrons.cell[p], electrons.weight[p]);
+        }
+
+    // remove the particles that were merged into the others
+    electrons.clear_lost();
+    return electrons.size() - n_old;
+}
+
+template<int dim>
+void Pic<dim>::merge_particles(int* parts, const int n_parts, const int group_size) {
+    // group particles with similar kinetic energy
+    std::sort(parts, parts + n_parts, [this](int p1, int p2) {
+        const double v1 = electrons.vel[p1].norm2();
+        const double v2 = electrons.vel[p2].norm2();
+        return v1 < v2 || (v1 == v2 && p1 < p2);
+    });
+
+    for (int start = 0; start < n_parts; start += group_size) {
+        const int end = min(n_parts, start + group_size);
+        if (end - start < 3) continue;
+
+        // total weight, momentum, kinetic energy and center of mass of the group
+        double W = 0, K = 0;
+        Vec3 P(0), X(0);
+        for (int i = start; i < end; ++i) {
+            const int p = parts[i];
+            const double w = electrons.weight[p];
+            W += w;
+            P += electrons.vel[p] * w;
+            K += electrons.vel[p].norm2() * w;
+            X += Vec3(electrons.pos[p]) * w;
+        }
+
+        const Vec3 u = P / W;
+        const double sigma2 = max(0.0, K / W - u.norm2());
+
+        // spread the velocities of new particles along the direction of the largest deviation
+        Vec3 direction(1, 0, 0);
+        double max_dev = 0;
+        for (int i = start; i < end; ++i) {
+            const Vec3 dev = electrons.vel[parts[i]] - u;
+            if (dev.norm2() > max_dev) {
+                max_dev = dev.norm2();
+                direction = dev;
+            }
+        }
+        if (max_dev > 0) direction *= 1.0 / sqrt(max_dev);
+        const Vec3 delta = direction * sqrt(sigma2);
+
+        // two new particles conserve charge, momentum and energy of the group
+        const int p1 = parts[start];
+        const int p2 = parts[start + 1];
+        electrons.pos[p1] = X / W;
+        electrons.pos[p2] = X / W;
+        electrons.vel[p1] = u + delta;
+        electrons.vel[p2] = u - delta;
+        electrons.weight[p1] = 0.5 * W;
+        electrons.weight[p2] = 0.5 * W;
+
+        // mark the rest of the group to be deleted
+        for (int i = start + 2; i < end; ++i)
+            electrons.cell[parts[i]] = -1;
+    }
+}
+
+template<int dim>
+void Pic<dim>::split_particles(int* parts, const int n_parts, const int n_new, const int cell,
+        RandomStream &rng, vector<pair<int,Vec3>> &splits)
+{
+    // split the heaviest particles first
+    std::sort(parts, parts + n_parts, [this](int p1, int p2) {
+        const double w1 = electrons.weight[p1];
+        const double w2 = electrons.weight[p2];
+        return w1 > w2 || (w1 == w2 && p1 < p2);
+    });
+
+    const int femocs_cell = interpolator->linhex.deal2femocs(cell);
+    const double shift = 0.1 * cbrt(poisson_solver->get_cell_vol(cell));
+    std::normal_distribution<double> rnd_gauss(0.0, 1.0);
+
+    for (int i = 0; i < min(n_parts, n_new); ++i) {
+        const int p = parts[i];
+        if (electrons.weight[p] < min_split_weight) break;
+
+        // displace the halves symmetrically, so that the center of mass is preserved
+        Vec3 d(rnd_gauss(rng), rnd_gauss(rng), rnd_gauss(rng));
+        d *= shift / max(1e-10, d.norm());
+        Point3 &pos = electrons.pos[p];
+        if (!interpolator->linhex.point_in_cell(pos + d, femocs_cell) ||
+                !interpolator->linhex.point_in_cell(pos - d, femocs_cell))
+            d = Vec3(0);
+
+        pos += d;
+        electrons.weight[p] *= 0.5;
+        splits.push_back({p, d});
+    }
+}
+
+template<int dim>
+void Pic<dim>::group_particles(vector<int> &particles, vector<int> &cell_starts) const {
     const int n_cells = poisson_solver->get_n_cells();
     const int n_particles = electrons.size();
 
-    // Group particles
-    parts_in_cell = vector<vector<size_t>>(n_cells);
-    for (size_t p = 0; p < n_particles; ++p) {
-        int cell = electrons[p].cell;
+    // count the particles in each cell
+    cell_starts = vector<int>(n_cells + 1, 0);
+    for (int p = 0; p < n_particles; ++p) {
+        int cell = electrons.cell[p];
         require(cell < n_cells, "Invalid cell " + d2s(cell) + " associated with superparticle " + d2s(p));
-        if (cell >= 0) parts_in_cell[cell].push_back(p);
+        if (cell >= 0) cell_starts[cell+1]++;
     }
 
-    // Randomize the ordering of particles in a group
-    for (vector<size_t> &particles : parts_in_cell) {
-        int n_particles = particles.size();
-        // no need to shuffle <= 3 particles, as their pairing doesn't change
-        if (n_particles > 3) {
-            std::uniform_int_distribution<int> rnd_int(0, n_particles-1);
+    for (int i = 0; i < n_cells; ++i)
+        cell_starts[i+1] += cell_starts[i];
+
+    // Group particles; within a cell they remain in ascending order
+    vector<int> offsets(cell_starts.begin(), cell_starts.end() - 1);
+    particles.resize(cell_starts[n_cells]);
+    for (int p = 0; p < n_particles; ++p) {
+        int cell = electrons.cell[p];
+        if (cell >= 0) particles[offsets[cell]++] = p;
+    }
+}
 
-            for (size_t &p : particles) {
-                int new_index = rnd_int(mersenne);
-                std::swap(p, particles[new_index]);
+template<int dim>
+uint64_t Pic<dim>::get_stream_step(const uint64_t tag) const {
+    return ((uint64_t(GLOBALS.TIMESTEP) << 32) + data.n_pushes) | tag;
+}
+
+template<int dim>
+double Pic<dim>::calc_max_shift() const {
+    const int n_electrons = electrons.size();
+    double max_shift = 0;
+
+#pragma omp parallel
+    {
+        int prev_cell = -1;
+        double cell_size = 1;
+
+#pragma omp for schedule(static) reduction(max:max_shift)
+        for (int i = 0; i < n_electrons; ++i) {
+            if (electrons.cell[i] != prev_cell) {
+                prev_cell = electrons.cell[i];
+                cell_size = cbrt(poisson_solver->get_cell_vol(prev_cell));
             }
+            max_shift = max(max_shift, electrons.vel[i].norm() * data.dt_prev / cell_size);
         }
     }
+
+    return max_shift;
+}
+
+template<int dim>
+double Pic<dim>::calc_max_dt(string &limiter) const {
+    const int n_cells = poisson_solver->get_n_cells();
+    const int n_electrons = electrons.size();
+
+    // find the charge and max speed of SP-s in every cell
+    vector<double> charge(n_cells, 0.0), max_v2(n_cells, 0.0);
+    for (int i = 0; i < n_electrons; ++i) {
+        const int cell = electrons.cell[i];
+        charge[cell] += electrons.weight[i];
+        max_v2[cell] = max(max_v2[cell], electrons.vel[i].norm2());
+    }
+
+    double dt_cross = 1e100, dt_plasma = 1e100;
+    const double density_factor = electrons.get_Wsp() * e_over_eps0 * e_over_me;
+
+#pragma omp parallel for reduction(min:dt_cross,dt_plasma)
+    for (int cell = 0; cell < n_cells; ++cell) {
+        if (charge[cell] <= 0) continue;
+        const double volume = poisson_solver->get_cell_vol(cell);
+
+        // time for the fastest SP in the cell to cross the given fraction of the cell
+        if (max_v2[cell] > 0)
+            dt_cross = min(dt_cross, conf->courant * cbrt(volume) / sqrt(max_v2[cell]));
+
+        // resolve the plasma oscillations; omega_p^2 = n e^2 / (eps0 m_e)
+        const double omega_p = sqrt(density_factor * charge[cell] / volume);
+        dt_plasma = min(dt_plasma, plasma_factor / omega_p);
+    }
+
+    limiter = "dt_max";
+    double dt = conf->dt_max;
+    if (dt_cross < dt) {
+        dt = dt_cross;
+        limiter = "cell crossing";
+    }
+    if (dt_plasma < dt) {
+        dt = dt_plasma;
+        limiter = "plasma frequency";
+    }
+    return dt;
+}
+
+template<int dim>
+double Pic<dim>::calc_charge(Point3 &center) const {
+    const int n_electrons = electrons.size();
+    double charge = 0, x = 0, y = 0, z = 0;
+
+#pragma omp parallel for reduction(+:charge,x,y,z)
+    for (int i = 0; i < n_electrons; ++i) {
+        const double w = electrons.weight[i];
+        charge += w;
+        x += w * electrons.pos[i].x;
+        y += w * electrons.pos[i].y;
+        z += w * electrons.pos[i].z;
+    }
+
+    if (charge > 0)
+        center = Point3(x / charge, y / charge, z / charge);
+    else
+        center = Point3(0);
+    return charge;
 }
 
 template<int dim>
@@ -356,6 +683,13 @@ void Pic<dim>::read(const string &filename) {
                 in.read(reinterpret_cast<char*>(&electron), sizeof(SuperParticle));
                 electrons.inject_particle(electron);
             }
+
+            // relative weights of SP-s are present only in newer restart files
+            if (in.peek() == 'W') {
+                in.get();
+                in.read(reinterpret_cast<char*>(&electrons.weight[electrons.size() - n_electrons]),
+                        n_electrons * sizeof(double));
+            }
         }
     }
 
@@ -376,14 +710,22 @@ void Pic<dim>::write_xyz(ofstream &out) const {
         out << "-1 0.0 0.0 0.0 0.0 0.0 0.0 0\n";
     } else {
         for (int i = 0; i < n_electrons;  ++i)
-            out << i << " " << electrons[i] << "\n";
+            out << i << " " << electrons.get_particle(i) << "\n";
     }
 }
 
 template<int dim>
 void Pic<dim>::write_bin(ofstream &out) const {
-    for (SuperParticle const &sp : electrons)
+    // keep the file format compatible with the array-of-structures layout
+    const int n_electrons = electrons.size();
+    for (int i = 0; i < n_electrons; ++i) {
+        SuperParticle sp = electrons.get_particle(i);
         out.write ((char*)&sp, sizeof (SuperParticle));
+    }
+
+    // relative weights are written after the particles to be able to read older files
+    out << 'W';
+    out.write ((char*)electrons.weight.data(), n_electrons * sizeof (double));
 }
 
 //Tell the compiler which types to actually compile, so that they are available for the linker
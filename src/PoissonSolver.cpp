@@ -3,10 +3,13 @@
 #include <deal.II/grid/grid_tools.h>
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/base/work_stream.h>
+#include <deal.II/lac/solver_cg.h>
 
 #include "PoissonSolver.h"
 #include "Globals.h"
 
+#include <omp.h>
+
 
 namespace femocs {
 
@@ -37,7 +40,8 @@ public:
 
 template<int dim>
 PoissonSolver<dim>::PoissonSolver() : DealSolver<dim>(),
-        particles(NULL), conf(NULL), interpolator(NULL), applied_field(0), applied_potential(0)
+        particles(NULL), conf(NULL), interpolator(NULL), applied_field(0), applied_potential(0),
+        bc_field(0), bc_potential(0)
         {}
 
 template<int dim>
@@ -45,7 +49,7 @@ PoissonSolver<dim>::PoissonSolver(const ParticleSpecies* particles_,
         const Config::Field* conf_, const LinearHexahedra* interpolator_) :
         DealSolver<dim>(),
         particles(particles_), conf(conf_), interpolator(interpolator_),
-        applied_field(0), applied_potential(0)
+        applied_field(0), applied_potential(0), bc_field(0), bc_potential(0)
         {}
 
 template<int dim>
@@ -153,44 +157,47 @@ double PoissonSolver<dim>::get_face_bc(const unsigned int face) const {
     return applied_field;
 }
 
-template<int dim>
-void PoissonSolver<dim>::restore_system_matrix() {
-    this->system_matrix.copy_from(this->system_matrix_save);
-}
-
 template<int dim>
 void PoissonSolver<dim>::setup(const double field, const double potential) {
-    DealSolver<dim>::setup_system();
-    this->system_matrix_save.reinit(this->sparsity_pattern);
+    require(conf, "NULL conf can't be used!");
+    laplace_operator.clear();
+    DealSolver<dim>::setup_system(!conf->matrix_free);
     applied_field = field;
     applied_potential = potential;
 }
 
 template<int dim>
-void PoissonSolver<dim>::assemble(const bool full_run) {
+void PoissonSolver<dim>::assemble(bool full_run) {
     require(conf, "NULL conf can't be used!");
     require(conf->anode_BC == "neumann" || conf->anode_BC == "dirichlet",
             "Unimplemented anode BC: " + conf->anode_BC);
 
-    if (full_run) this->system_matrix = 0;
-    this->system_rhs = 0;
-
-    if (conf->anode_BC == "neumann") {
-        if (full_run)
-            assemble_parallel();
-        else
-            restore_system_matrix();
+    // The matrix and the BC-s don't change between mesh updates. Therefore the Dirichlet BC-s
+    // are applied to the matrix only once and the resulting constant part of the rhs is stored.
+    // During the subsequent calls only the space charge part of the rhs is rebuilt.
+    // In matrix-free mode the global matrix is not assembled at all.
+    full_run |= bc_field != applied_field || bc_potential != applied_potential;
+    if (full_run) {
+        this->system_rhs = 0;
         this->append_dirichlet(BoundaryID::copper_surface, this->dirichlet_bc_value);
-        this->assemble_rhs(BoundaryID::vacuum_top);
-    } else {
-        if (full_run)
-            assemble_parallel();
+        if (conf->anode_BC == "neumann")
+            this->assemble_rhs(BoundaryID::vacuum_top);
         else
-            restore_system_matrix();
-        this->append_dirichlet(BoundaryID::copper_surface, this->dirichlet_bc_value);
-        this->append_dirichlet(BoundaryID::vacuum_top, applied_potential);
+            this->append_dirichlet(BoundaryID::vacuum_top, applied_potential);
+
+        if (conf->matrix_free)
+            setup_matrix_free();
+        else {
+            this->system_matrix = 0;
+            assemble_parallel();
+            this->apply_dirichlet();
+        }
+        system_rhs_bc = this->system_rhs;
+        bc_field = applied_field;
+        bc_potential = applied_potential;
     }
 
+    this->system_rhs = 0;
     if (conf->mode != "laplace") assemble_space_charge();
 
     // save charge density for writing it to file
@@ -206,7 +213,98 @@ void PoissonSolver<dim>::assemble(const bool full_run) {
     } else
         this->charge_density.reinit(this->system_rhs.size());
 
-    this->apply_dirichlet();
+    this->apply_dirichlet_rhs(system_rhs_bc);
+}
+
+template<int dim>
+int PoissonSolver<dim>::calc_laplace_basis() {
+    require(is_linear(), "Laplace basis can't be used in the presence of space charge!");
+    require(this->dirichlet_bc_value == 0, "Superposition requires zero potential on copper surface!");
+
+    // Only the field (Neumann BC) or the potential (Dirichlet BC) on top of simubox contributes to the solution,
+    // so one solve is sufficient
+    const double field = applied_field;
+    const double potential = applied_potential;
+    const bool neumann = conf->anode_BC == "neumann";
+    applied_field = neumann ? 1.0 : 0.0;
+    applied_potential = neumann ? 0.0 : 1.0;
+
+    this->solution = 0;
+    assemble(true);
+    const int n_cg = solve();
+
+    if (n_cg < 0)
+        clear_laplace_basis();
+    else if (neumann) {
+        laplace_basis.field = this->solution;
+        laplace_basis.potential.reinit(this->solution.size());
+    } else {
+        laplace_basis.field.reinit(this->solution.size());
+        laplace_basis.potential = this->solution;
+    }
+
+    applied_field = field;
+    applied_potential = potential;
+    if (has_laplace_basis())
+        superpose_laplace_basis(field, potential);
+    return n_cg;
+}
+
+template<int dim>
+void PoissonSolver<dim>::superpose_laplace_basis(const double field, const double potential) {
+    require(has_laplace_basis(), "Laplace basis is not calculated for current mesh!");
+    applied_field = field;
+    applied_potential = potential;
+    this->solution.equ(field, laplace_basis.field, potential, laplace_basis.potential);
+}
+
+template<int dim>
+void PoissonSolver<dim>::setup_matrix_free() {
+    laplace_operator.initialize(this->dof_handler, this->boundary_values);
+    laplace_operator.apply_lifting(this->system_rhs, this->boundary_values);
+
+    typename PreconditionChebyshev<LaplaceOperator<dim>, Vector<double>>::AdditionalData data;
+    data.degree = chebyshev_degree;
+    data.smoothing_range = chebyshev_range;
+    data.matrix_diagonal_inverse = laplace_operator.get_inv_diag();
+    chebyshev.initialize(laplace_operator, data);
+}
+
+template<int dim>
+int PoissonSolver<dim>::solve() {
+    if (conf->matrix_free)
+        return solve_matrix_free();
+    return this->solve_cg(conf->n_cg, conf->cg_tolerance, conf->ssor_param, conf->preconditioner);
+}
+
+template<int dim>
+int PoissonSolver<dim>::solve_matrix_free() {
+    require(laplace_operator.m() == this->size(), "Matrix-free operator is not initialized!");
+
+    // Operator acts as identity on Dirichlet dofs and the rhs there is zero,
+    // so the equation is solved for the deviation from the Dirichlet values
+    for (auto const &bv : this->boundary_values)
+        this->solution[bv.first] = 0;
+
+    const double t_start = omp_get_wtime();
+    SolverControl solver_control(conf->n_cg, conf->cg_tolerance);
+    SolverCG<> solver(solver_control);
+    int n_steps;
+    try {
+        if (conf->preconditioner == "none")
+            solver.solve(laplace_operator, this->solution, this->system_rhs, PreconditionIdentity());
+        else
+            solver.solve(laplace_operator, this->solution, this->system_rhs, chebyshev);
+        n_steps = solver_control.last_step();
+    } catch (exception &exc) {
+        n_steps = -1 * solver_control.last_step();
+    }
+
+    for (auto const &bv : this->boundary_values)
+        this->solution[bv.first] = bv.second;
+
+    this->store_solver_stats(solver_control, n_steps, t_start);
+    return n_steps;
 }
 
 template<int dim>
@@ -230,9 +328,6 @@ void PoissonSolver<dim>::assemble_parallel() {
             ScratchData(this->fe, quadrature_formula, update_gradients | update_quadrature_points | update_JxW_values),
             CopyData(n_dofs, n_q_points)
     );
-
-    // save system matrix
-    this->system_matrix_save.copy_from(this->system_matrix);
 }
 
 template<int dim>
@@ -278,20 +373,23 @@ void PoissonSolver<dim>::assemble_space_charge() {
     vector<types::global_dof_index> local_dof_indices(this->fe.dofs_per_cell);
 
     // loop over particles
-    for (SuperParticle const &particle : *particles) {
-        Point<dim> p_deal = Point<dim>(particle.pos.x, particle.pos.y, particle.pos.z);
+    const int n_particles = particles->size();
+    for (int p = 0; p < n_particles; ++p) {
+        const Point3 &pos = particles->pos[p];
+        const int particle_cell = particles->cell[p];
+        Point<dim> p_deal = Point<dim>(pos.x, pos.y, pos.z);
         //get particle's active cell iterator
-        typename DoFHandler<dim>::active_cell_iterator cell(&this->triangulation, 0, particle.cell, &this->dof_handler);
+        typename DoFHandler<dim>::active_cell_iterator cell(&this->triangulation, 0, particle_cell, &this->dof_handler);
 
         //get the node indices of the particle's cell
         cell->get_dof_indices(local_dof_indices);
 
         //get the shape functions of the cell on the given point
-        vector<double> sf = this->shape_funs(p_deal, particle.cell);
+        vector<double> sf = this->shape_funs(p_deal, particle_cell);
 
         //loop over nodes of the cell and add the particle's charge to the system rhs
         for (unsigned int i = 0; i < this->fe.dofs_per_cell; ++i)
-            this->system_rhs(local_dof_indices[i]) += sf[i] * particles->q_over_eps0 * particles->get_Wsp();
+            this->system_rhs(local_dof_indices[i]) += sf[i] * particles->q_over_eps0 * particles->get_Wsp() * particles->weight[p];
     }
 }
 
@@ -300,21 +398,52 @@ template<>
 void PoissonSolver<3>::assemble_space_charge_fast() {
     static constexpr int n_dofs = GeometryInfo<3>::vertices_per_cell;
     const double charge_factor = particles->q_over_eps0 * particles->get_Wsp();
-    vector<types::global_dof_index> local_dof_indices(n_dofs);
+    const int n_particles = particles->size();
+    const int n_rhs = this->system_rhs.size();
+
+    // to avoid race conditions, every thread accumulates its contribution into separate vector
+    vector<vector<double>> partial_rhs(omp_get_max_threads());
+
+#pragma omp parallel
+    {
+        vector<double> &rhs = partial_rhs[omp_get_thread_num()];
+        rhs.assign(n_rhs, 0.0);
+        vector<types::global_dof_index> local_dof_indices(n_dofs);
+        int prev_cell = -1;
+
+        // loop over particles; if they are sorted by cells,
+        // the dof indices are obtained only once per cell.
+        // Static scheduling keeps the distribution of particles between threads fixed.
+#pragma omp for schedule(static)
+        for (int p = 0; p < n_particles; ++p) {
+            const int particle_cell = particles->cell[p];
+
+            // get the node indices of the particle's cell
+            if (particle_cell != prev_cell) {
+                typename DoFHandler<3>::active_cell_iterator cell(&this->triangulation, 0, particle_cell, &this->dof_handler);
+                cell->get_dof_indices(local_dof_indices);
+                prev_cell = particle_cell;
+            }
 
-    // loop over particles
-    for (SuperParticle const &particle : *particles) {
-        // get the node indices of the particle's cell
-        typename DoFHandler<3>::active_cell_iterator cell(&this->triangulation, 0, particle.cell, &this->dof_handler);
-        cell->get_dof_indices(local_dof_indices);
+            //get the shape functions of the cell on the given point
+            int femocs_cell = interpolator->deal2femocs(particle_cell);
+            array<double,n_dofs> shape_fun = interpolator->shape_funs_dealii(particles->pos[p], femocs_cell);
 
-        //get the shape functions of the cell on the given point
-        int femocs_cell = interpolator->deal2femocs(particle.cell);
-        array<double,n_dofs> shape_fun = interpolator->shape_funs_dealii(particle.pos, femocs_cell);
+            //loop over nodes of the cell and add the particle's charge to the thread-local rhs
+            const double charge = charge_factor * particles->weight[p];
+            for (int i = 0; i < n_dofs; ++i)
+                rhs[local_dof_indices[i]] += shape_fun[i] * charge;
+        }
+    }
 
-        //loop over nodes of the cell and add the particle's charge to the system rhs
-        for (int i = 0; i < n_dofs; ++i)
-            this->system_rhs(local_dof_indices[i]) += shape_fun[i] * charge_factor;
+    // Sum the contributions of the threads always in the same order
+    // to make the result bitwise reproducible for fixed nr of threads
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n_rhs; ++i) {
+        double charge = 0;
+        for (const vector<double> &rhs : partial_rhs)
+            if (!rhs.empty()) charge += rhs[i];
+        this->system_rhs(i) += charge;
     }
 }
 
@@ -73,6 +73,9 @@ int ProjectHeat::run_heat_solver() {
     if (conf.heating.mode == "converge")
         return converge_heat(conf.heating.t_ambient);
 
+    if (conf.heating.mode == "steady")
+        return solve_steady_heat(mesh_changed);
+
     if (mesh_changed && conf.heating.mode == "transient")
         return solve_heat(conf.heating.t_ambient, GLOBALS.TIME - last_heat_time, true, ccg, hcg);
 
@@ -98,7 +101,9 @@ int ProjectHeat::converge_heat(double T_ambient) {
         vacuum_interpolator.nodes.write("out/result_E_phi.movie", true);
         bulk_interpolator.nodes.write("out/result_J_T.movie", true);
 
-        if (hcg < (ccg - 10) && delta_time <= conf.heating.dt_max / 1.25) // heat changed too little?
+        if (conf.heating.dt_tolerance > 0) // use the step proposed by the error control
+            delta_time = heat_dt;
+        else if (hcg < (ccg - 10) && delta_time <= conf.heating.dt_max / 1.25) // heat changed too little?
             delta_time *= 1.25;
         else if (hcg > (ccg + 10)) // heat changed too much?
             delta_time /= 1.25;
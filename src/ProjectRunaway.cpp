@@ -21,6 +21,7 @@ ProjectRunaway::ProjectRunaway(AtomReader &reader, Config &config) :
         fail(false), t0(0), mesh_changed(false), first_run(true),
 		last_heat_time(-conf.behaviour.timestep_fs),
 		last_pic_time(-conf.behaviour.timestep_fs),
+		heat_dt(conf.heating.delta_time),
 		last_restart_ts(0),
 
         vacuum_interpolator(LABELS.elfield, LABELS.charge_density, LABELS.potential),
@@ -33,6 +34,7 @@ ProjectRunaway::ProjectRunaway(AtomReader &reader, Config &config) :
         surface_fields(&vacuum_interpolator),
         surface_temperatures(&bulk_interpolator),
         heat_transfer(&bulk_interpolator),
+        field_transfer(&vacuum_interpolator),
 
         phys_quantities(config.heating),
         poisson_solver(NULL, &config.field, &vacuum_interpolator.linhex),
@@ -45,7 +47,10 @@ ProjectRunaway::ProjectRunaway(AtomReader &reader, Config &config) :
     poisson_solver.set_particles(pic_solver.get_particles());
 
     surface_fields.set_preferences(false, 2, 3, true);
+    surface_fields.set_sparse_interpolation(true);
+    surface_temperatures.set_sparse_interpolation(true);
     heat_transfer.set_preferences(true, 3, 1, false);
+    field_transfer.set_preferences(true, 3, 1, false);
 
     start_msg(t0, "Reading physical quantities");
     phys_quantities.initialize_with_hc_data();
@@ -214,6 +219,7 @@ int ProjectRunaway::generate_mesh() {
 int ProjectRunaway::import_mesh() {
     start_msg(t0, "Importing vacuum mesh to Deal.II");
     fail = !poisson_solver.import_mesh(mesh->nodes.export_dealii(), mesh->hexs.export_vacuum());
+    poisson_solver.clear_laplace_basis();
     check_return(fail, "Importing vacuum mesh to Deal.II failed!");
     end_msg(t0);
 
@@ -263,6 +269,10 @@ int ProjectRunaway::prepare_solvers() {
 
     // initialize the calculation of field emission
     if (mesh_changed) {
+        // interpolation weights of the surface points belong to the old mesh
+        surface_fields.reset_mapping();
+        surface_temperatures.reset_mapping();
+
         // setup ch_solver here as it must be done before transferring previous heat values into new mesh,
         // which in turn must be done before re-initializing bulk_interpolator
         start_msg(t0, "Setup current & heat solvers");
@@ -370,6 +380,10 @@ int ProjectRunaway::run_heat_solver() {
     if (conf.heating.mode == "transient" && (mesh_changed || b1))
         return solve_heat(conf.heating.t_ambient, delta_time, mesh_changed, ccg, hcg);
 
+    // with frozen Laplace field the emission changes only together with the mesh
+    if (conf.heating.mode == "steady" && (mesh_changed || conf.field.mode != "laplace"))
+        return solve_steady_heat(mesh_changed);
+
     return 0;
 }
 
@@ -419,24 +433,64 @@ int ProjectRunaway::solve_force() {
     return 0;
 }
 
-int ProjectRunaway::solve_laplace(double E0, double V0) {
-    start_msg(t0, "Initializing Laplace solver");
-    poisson_solver.setup(-E0, V0);
-    poisson_solver.assemble(true);
+void ProjectRunaway::transfer_potential() {
+    // in case of first run, there is no previous solution to transfer
+    if (vacuum_interpolator.nodes.size() == 0) return;
+
+    start_msg(t0, "Transferring old potential to new mesh");
+    field_transfer.interpolate_dofs(poisson_solver);
     end_msg(t0);
+}
 
-    write_verbose_msg(poisson_solver.to_str());
+int ProjectRunaway::solve_laplace(double E0, double V0) {
+    // Without space charge the solution is linear in applied field and potential.
+    // In that case the solution for unit field or potential is calculated once per mesh
+    // and the solutions for other values are obtained by scaling it.
+    const bool linear = poisson_solver.is_linear();
+
+    if (!linear || !poisson_solver.has_laplace_basis()) {
+        start_msg(t0, "Initializing Laplace solver");
+        poisson_solver.setup(-E0, V0);
+        end_msg(t0);
 
-    start_msg(t0, "Running Laplace solver");
-    int ncg = poisson_solver.solve();
-    end_msg(t0);
-    check_return(ncg < 0, "Field solver did not complete normally,"
-            " #CG=" + d2s(abs(ncg)) + "/" + d2s(conf.field.n_cg));
+        if (!linear) {
+            transfer_potential();
+            poisson_solver.assemble(true);
+        }
 
-    start_msg(t0, "Extracting E & phi");
-    vacuum_interpolator.initialize(mesh, 0, TYPES.VACUUM);
-    vacuum_interpolator.extract_solution(poisson_solver, conf.run.field_smoother);
-    end_msg(t0);
+        write_verbose_msg(poisson_solver.to_str());
+
+        start_msg(t0, "Running Laplace solver");
+        int ncg = linear ? poisson_solver.calc_laplace_basis() : poisson_solver.solve();
+        end_msg(t0);
+        check_return(ncg < 0, "Field solver did not complete normally,"
+                " #CG=" + d2s(abs(ncg)) + "/" + d2s(conf.field.n_cg));
+
+        vacuum_interpolator.clear_basis();
+    }
+
+    if (linear) {
+        // depending on anode BC, only applied field or potential affects the solution
+        const bool neumann = conf.field.anode_BC == "neumann";
+        if (vacuum_interpolator.get_n_basis() != 1) {
+            start_msg(t0, "Extracting E & phi basis");
+            vacuum_interpolator.initialize(mesh, 0, TYPES.VACUUM);
+            poisson_solver.superpose_laplace_basis(neumann, !neumann);
+            vacuum_interpolator.extract_solution(poisson_solver, conf.run.field_smoother);
+            vacuum_interpolator.append_basis();
+            end_msg(t0);
+        }
+
+        start_msg(t0, "Superposing Laplace solutions");
+        poisson_solver.superpose_laplace_basis(-E0, V0);
+        vacuum_interpolator.superpose_basis({neumann ? -E0 : V0});
+        end_msg(t0);
+    } else {
+        start_msg(t0, "Extracting E & phi");
+        vacuum_interpolator.initialize(mesh, 0, TYPES.VACUUM);
+        vacuum_interpolator.extract_solution(poisson_solver, conf.run.field_smoother);
+        end_msg(t0);
+    }
 
     vacuum_interpolator.nodes.write("result_E_phi.xyz");
     vacuum_interpolator.lintet.write("result_E_phi.vtk");
@@ -456,33 +510,63 @@ int ProjectRunaway::solve_pic(double advance_time, bool full_run) {
     if (full_run) {
         start_msg(t0, "Initializing Poisson solver");
         poisson_solver.setup(-conf.field.E0, conf.field.V0);
+        end_msg(t0);
+
+        transfer_potential();
+
+        start_msg(t0, "Initializing vacuum interpolator");
         vacuum_interpolator.initialize(mesh, 0, TYPES.VACUUM);
+        pic_solver.update_cells();
         end_msg(t0);
         write_verbose_msg(poisson_solver.to_str());
     }
     cout << fixed << setprecision(3);
 
     int n_lost, n_cg, n_injected, error;
-    start_msg(t0, "=== Running PIC for delta time = "
-            + d2s(n_pic_steps) + "*" + d2s(dt_pic)+" = " + d2s(advance_time) + " fs\n");
-
+    subcycling.n_skipped = 0;
+    if (conf.pic.adaptive_dt)
+        start_msg(t0, "=== Running PIC with adaptive timestep for delta time = " + d2s(advance_time) + " fs\n");
+    else
+        start_msg(t0, "=== Running PIC for delta time = "
+                + d2s(n_pic_steps) + "*" + d2s(dt_pic)+" = " + d2s(advance_time) + " fs\n");
+
+    double time_left = advance_time;
     for (int i = 0; i < n_pic_steps; ++i) {
+        if (conf.pic.adaptive_dt) {
+            // distribute remaining time evenly between the steps that satisfy the stability limits
+            string limiter;
+            double dt_max = pic_solver.calc_max_dt(limiter);
+            check_return(dt_max < conf.pic.dt_min, "PIC timestep limited by " + limiter
+                    + " is too small: " + d2s(dt_max) + " fs < " + d2s(conf.pic.dt_min) + " fs");
+            int n_steps_left = ceil(time_left / dt_max - 1e-6);
+            dt_pic = time_left / max(1, n_steps_left);
+            n_pic_steps = i + n_steps_left;
+            pic_solver.set_dt(dt_pic);
+            write_log("PIC dt=" + d2s(dt_pic, 3) + " fs, limited by " + limiter
+                    + ", dt_limit=" + d2s(dt_max, 3) + " fs");
+        }
+
         error = make_pic_step(n_lost, n_cg, n_injected, full_run && i==0);
         if (error) return 1;
 
         if (MODES.VERBOSE) {
-            printf("  t=%.2f, #CG=%d, Vmin=%.1f V, Jmax=%.0e, Fmax=%.3f V/A, Itot=%.3e A, M/A=%.3f, #inj|del|tot=%d|%d|%d",
-                    GLOBALS.TIME, n_cg, poisson_solver.stat.sol_min, emission.global_data.Jmax,
+            printf("  t=%.2f, dt=%.3f, #CG=%d, Vmin=%.1f V, Jmax=%.0e, Fmax=%.3f V/A, Itot=%.3e A, M/A=%.3f, #inj|del|tot|slow=%d|%d|%d|%d",
+                    GLOBALS.TIME, dt_pic, n_cg, poisson_solver.stat.sol_min, emission.global_data.Jmax,
                     emission.global_data.Fmax, emission.global_data.I_tot, fields.get_beta(),
-                    n_injected, n_lost, pic_solver.get_n_electrons());
+                    n_injected, n_lost, pic_solver.get_n_electrons(), pic_solver.get_n_slow_locates());
             cout << endl;
         }
 
         GLOBALS.TIME += dt_pic;
         last_pic_time += dt_pic;
+        time_left -= dt_pic;
     }
     end_msg(t0);
 
+    if (conf.pic.max_subcycles > 1)
+        write_verbose_msg("Skipped " + d2s(subcycling.n_skipped) + " of "
+                + d2s(n_pic_steps) + " field solves");
+
     vacuum_interpolator.nodes.write("result_E_phi.xyz");
     vacuum_interpolator.lintet.write("result_E_phi.vtk");
 
@@ -490,39 +574,44 @@ int ProjectRunaway::solve_pic(double advance_time, bool full_run) {
 }
 
 int ProjectRunaway::make_pic_step(int& n_lost, int& n_cg, int& n_injected, bool full_run) {
-    // advance super particles
-    n_lost = pic_solver.update_positions();
+    n_cg = 0;
 
-    // assemble and solve Poisson equation
-    poisson_solver.assemble(full_run);
-    n_cg = poisson_solver.solve();
+    // skip the field solve if the space charge has changed only a little
+    if (need_field_solve(full_run)) {
+        // assemble and solve Poisson equation
+        poisson_solver.assemble(full_run);
+        n_cg = poisson_solver.solve();
 
-    // the check must be after solving Poisson eq. and before updating velocities
-    check_return(n_cg < 0, "Poisson solver did not converge within nominal #CG steps!");
-    fail = poisson_solver.check_limits(conf.field.V_min, conf.field.V_max);
-    check_return(fail, "Potential is out of limits, " + d2s(poisson_solver.stat));
+        // the check must be after solving Poisson eq. and before updating velocities
+        check_return(n_cg < 0, "Poisson solver did not converge within nominal #CG steps!");
+        fail = poisson_solver.check_limits(conf.field.V_min, conf.field.V_max);
+        check_return(fail, "Potential is out of limits, " + d2s(poisson_solver.stat));
 
-    vacuum_interpolator.extract_solution(poisson_solver, conf.run.field_smoother);
-    check_return(fields.check_limits(vacuum_interpolator.nodes.get_solutions(), false),
-            "Field enhancement is out of limits, M/A=" + d2s(fields.get_beta()));
+        vacuum_interpolator.extract_solution(poisson_solver, conf.run.field_smoother);
+        check_return(fields.check_limits(vacuum_interpolator.nodes.get_solutions(), false),
+                "Field enhancement is out of limits, M/A=" + d2s(fields.get_beta()));
 
-    // update velocities of super particles and collide them
-    pic_solver.update_velocities();
-    pic_solver.collide_particles();
+        // update field on the surface
+        surface_fields.calc_interpolation();
 
-    // update field on the surface
-    surface_fields.calc_interpolation();
+        // calculate field emission and Nottingham heat
+        int error_code = emission.calc_emission(conf.emission, 0.);
+        if (error_code == -10)
+            check_return(true, "Current density is out of limits, Jmax=" + d2s(emission.global_data.Jmax));
+        check_return(error_code, "Emission calculation failed with error code " + d2s(error_code));
+    }
 
-    // calculate field emission and Nottingham heat
-    int error_code = emission.calc_emission(conf.emission, 0.);
-    if (error_code == -10)
-        check_return(true, "Current density is out of limits, Jmax=" + d2s(emission.global_data.Jmax));
-    check_return(error_code, "Emission calculation failed with error code " + d2s(error_code));
+    // collide super particles
+    pic_solver.collide_particles();
 
     // inject new electrons
     n_injected = pic_solver.inject_electrons(conf.pic.fractional_push);
     check_return(n_injected < 0, "Too many injected SP-s: " + d2s(abs(n_injected)));
 
+    // update velocities and positions of super particles
+    n_lost = pic_solver.push_particles();
+    pic_solver.control_population();
+
     emission.write("emission.dat", FileIO::no_update);
     emission.write("emission.movie");
     pic_solver.write("electrons.movie");
@@ -532,6 +621,41 @@ int ProjectRunaway::make_pic_step(int& n_lost, int& n_cg, int& n_injected, bool
     return 0;
 }
 
+bool ProjectRunaway::need_field_solve(bool full_run) {
+    // avoid the passes over particles if the field must be solved anyway;
+    // as the reference charge is not updated then, the next check must solve the field as well
+    if (full_run || conf.pic.max_subcycles <= 1) {
+        subcycling.shift = 0;
+        subcycling.n_frozen = conf.pic.max_subcycles;
+        return true;
+    }
+
+    Point3 center;
+    const double charge = pic_solver.calc_charge(center);
+    const double height = mesh->nodes.stat.zmax - mesh->nodes.stat.zmin;
+
+    // indicator consists of relative change in total charge and shift of its centre
+    double change = fabs(charge - subcycling.charge) / max(1.0, subcycling.charge);
+    change += center.distance(subcycling.center) / height;
+
+    // the global indicator is blind to charge redistribution at constant total charge and centre,
+    // so the displacements of SP-s are accumulated as well
+    subcycling.shift += pic_solver.calc_max_shift();
+
+    bool solve = ++subcycling.n_frozen >= conf.pic.max_subcycles
+            || change > conf.pic.subcycle_tol || subcycling.shift > conf.pic.subcycle_shift;
+
+    if (solve) {
+        subcycling.charge = charge;
+        subcycling.center = center;
+        subcycling.shift = 0;
+        subcycling.n_frozen = 0;
+    } else
+        subcycling.n_skipped++;
+
+    return solve;
+}
+
 int ProjectRunaway::solve_heat(double T_ambient, double delta_time, bool full_run, int& ccg, int& hcg) {
     // Calculate field emission in case not ready from PIC
     if (conf.field.mode == "laplace")
@@ -546,8 +670,13 @@ int ProjectRunaway::solve_heat(double T_ambient, double delta_time, bool full_ru
     check_return(ccg < 0, "Current solver did not converge within nominal #CG steps!");
 
     start_msg(t0, "Calculating temperature distribution");
-    ch_solver.heat.assemble(delta_time * 1.e-15); // caution!! ch_solver internal time in sec
-    hcg = ch_solver.heat.solve();
+    if (conf.heating.dt_tolerance > 0) {
+        if (advance_heat(delta_time, hcg))
+            return 1;
+    } else {
+        ch_solver.heat.assemble(delta_time * 1.e-15); // caution!! ch_solver internal time in sec
+        hcg = ch_solver.heat.solve();
+    }
     end_msg(t0);
 
     fail = ch_solver.heat.check_limits(conf.heating.T_min,  conf.heating.T_max);
@@ -570,6 +699,72 @@ int ProjectRunaway::solve_heat(double T_ambient, double delta_time, bool full_ru
     return 0;
 }
 
+int ProjectRunaway::advance_heat(double delta_time, int& hcg) {
+    static constexpr int max_rejected = 100;  // max # rejected steps before giving up
+    const double tolerance = conf.heating.dt_tolerance;
+    double time_left = delta_time;
+    int n_accepted = 0, n_rejected = 0;
+
+    while (time_left > 1e-6 * delta_time) {
+        const double dt = min(min(heat_dt, conf.heating.dt_max), time_left);
+        const double error = ch_solver.heat.solve_embedded(dt * 1.e-15, hcg); // ch_solver internal time in sec
+        check_return(hcg < 0, "Heat solver did not converge within nominal #CG steps!");
+
+        const bool accepted = error <= tolerance;
+        write_log("Heat dt=" + d2s(dt, 3) + " fs, error=" + d2s(error, 3) + " K, "
+                + (accepted ? "accepted" : "rejected"));
+
+        // local error of implicit Euler is proportional to dt^2
+        double dt_new = dt * max(0.2, min(2.0, error > 0 ? 0.9 * sqrt(tolerance / error) : 2.0));
+        if (accepted) {
+            time_left -= dt;
+            n_accepted++;
+            // step limited by the end of interval is not a reason to decrease the step
+            if (dt < heat_dt) dt_new = max(dt_new, heat_dt);
+        } else {
+            ch_solver.heat.reject_step();
+            n_rejected++;
+            check_return(n_rejected > max_rejected, "Too many rejected heat steps!");
+        }
+        heat_dt = min(dt_new, conf.heating.dt_max);
+    }
+
+    write_verbose_msg("#accepted|rejected heat steps=" + d2s(n_accepted) + "|" + d2s(n_rejected)
+            + ", next dt=" + d2s(heat_dt, 3) + " fs");
+    return 0;
+}
+
+int ProjectRunaway::solve_steady_heat(bool full_run) {
+    // Calculate field emission in case not ready from PIC
+    if (conf.field.mode == "laplace")
+        if (calc_heat_emission(full_run))
+            return 1;
+
+    int ccg, hcg;
+    start_msg(t0, "Calculating stationary current density & temperature");
+    int n_newton = ch_solver.solve_steady(ccg, hcg);
+    end_msg(t0);
+
+    fail = ch_solver.heat.check_limits(conf.heating.T_min,  conf.heating.T_max);
+    write_verbose_msg("#Newton=" + d2s(abs(n_newton)) + ", #CG=" + d2s(ccg) + ", #GMRES=" + d2s(hcg)
+            + ", Tmin=" + d2s(ch_solver.heat.stat.sol_min) + " K, Tmax=" + d2s(ch_solver.heat.stat.sol_max) + " K");
+
+    check_return(n_newton < 0, "Steady heat solver did not converge within nominal #Newton steps!");
+    check_return(fail, "Temperature is out of limits!");
+    ch_solver.write("ch_solver.movie");
+
+    start_msg(t0, "Extracting J & T");
+    bulk_interpolator.initialize(mesh, conf.heating.t_ambient, TYPES.BULK);
+    bulk_interpolator.extract_solution(ch_solver);
+    end_msg(t0);
+
+    bulk_interpolator.nodes.write("result_J_T.xyz");
+    bulk_interpolator.lintet.write("result_J_T.vtk");
+
+    last_heat_time = GLOBALS.TIME;
+    return 0;
+}
+
 int ProjectRunaway::calc_heat_emission(bool full_run) {
     if (full_run) {
         start_msg(t0, "Calculating surface fields");
@@ -581,6 +776,8 @@ int ProjectRunaway::calc_heat_emission(bool full_run) {
     start_msg(t0, "Calculating electron emission");
     int error_code = emission.calc_emission(conf.emission, conf.emission.omega * conf.field.V0);
     end_msg(t0);
+    if (conf.emission.cache_ftol > 0 || conf.emission.table_tol > 0)
+        write_verbose_msg(d2s(emission.cache_stats));
     check_return(error_code, "Emission calculation failed with error code " + d2s(error_code));
     emission.write("emission.movie");
 
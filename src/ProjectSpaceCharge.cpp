@@ -76,6 +76,10 @@ int ProjectSpaceCharge::prepare(int i){
     int max_electrons = 500000;
     int max_Wsp_iter = 10;
 
+    // with population control, the nr of SP-s is bounded and
+    // changing the SP weight preserves the charge of existing SP-s
+    const bool keep_particles = conf.pic.particles_per_cell > 0;
+
     double init_factor, target_factor;
 
     start_msg(t0, "=== Preparing next applied field... \n");
@@ -86,7 +90,7 @@ int ProjectSpaceCharge::prepare(int i){
     else
         init_factor = conf.scharge.apply_factors[i-1];
 
-    if ((i == 0) || pic_solver.get_n_electrons() > max_electrons){
+    if ((i == 0) || (!keep_particles && pic_solver.get_n_electrons() > max_electrons)){
         pic_solver.reinit();
         init_factor = target_factor / 10;
     }
@@ -98,13 +102,17 @@ int ProjectSpaceCharge::prepare(int i){
             conf.pic.weight_el *= 10;
             write_verbose_msg("Trying with higher Wsp");
         } else if (inj_per_step < 1){
-            pic_solver.reinit();
+            if (!keep_particles) pic_solver.reinit();
             conf.pic.weight_el /= 10;
             write_verbose_msg("Trying with lower Wsp");
         } else if (inj_per_step < 200 || inj_per_step > 2000){
-            pic_solver.reinit();
             conf.pic.weight_el *= inj_per_step /  600;
-            init_factor = target_factor / 10; //reinitializing pic
+            if (keep_particles) {
+                init_factor = target_factor; // no need to ramp from scratch
+            } else {
+                pic_solver.reinit();
+                init_factor = target_factor / 10; //reinitializing pic
+            }
             write_verbose_msg("Resetting the particle weight to Wsp = "
                     + to_string(conf.pic.weight_el));
         } else
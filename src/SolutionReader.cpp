@@ -24,7 +24,7 @@ namespace femocs {
 SolutionReader::SolutionReader() :
         vec_label("vec"), norm_label("vec_norm"), scalar_label("scalar"),
         limit_min(0), limit_max(0), sort_atoms(false), interp_centroids(false),
-        dim(0), rank(0), interpolator(NULL)
+        dim(0), rank(0), interpolator(NULL), sparse_interpolation(false)
 {
     reserve(0);
 }
@@ -32,7 +32,7 @@ SolutionReader::SolutionReader() :
 SolutionReader::SolutionReader(Interpolator* i, const string& vec_lab, const string& vec_norm_lab, const string& scal_lab) :
         vec_label(vec_lab), norm_label(vec_norm_lab), scalar_label(scal_lab),
         limit_min(0), limit_max(0), sort_atoms(false), interp_centroids(false),
-        dim(0), rank(0), interpolator(i)
+        dim(0), rank(0), interpolator(i), sparse_interpolation(false)
 {
     reserve(0);
 }
@@ -131,6 +131,95 @@ void SolutionReader::interp_centroid(const int i) {
     }
 }
 
+void SolutionReader::interp_weights(const int i, vector<int> &node_indices, vector<double> &weights) const {
+    if (interp_centroids) {
+        int cell = get_marker(i);
+        if (dim == 2) {
+            if (rank == 1)
+                interpolator->lintri.centroid_weights(node_indices, weights, cell);
+            else if (rank == 2)
+                interpolator->quadtri.centroid_weights(node_indices, weights, cell);
+            else if (rank == 3)
+                interpolator->linquad.centroid_weights(node_indices, weights, cell);
+        } else {
+            if (rank == 1)
+                interpolator->lintet.centroid_weights(node_indices, weights, cell);
+            else if (rank == 2)
+                interpolator->quadtet.centroid_weights(node_indices, weights, cell);
+            else if (rank == 3)
+                interpolator->linhex.centroid_weights(node_indices, weights, cell);
+        }
+        return;
+    }
+
+    const Atom &atom = atoms[i];
+    int cell = abs(atom.marker);
+    if (dim == 2) {
+        if (rank == 1)
+            interpolator->lintri.interp_weights(node_indices, weights, atom.point, cell);
+        else if (rank == 2)
+            interpolator->quadtri.interp_weights(node_indices, weights, atom.point, cell);
+        else if (rank == 3)
+            interpolator->linquad.interp_weights(node_indices, weights, atom.point, cell);
+    } else {
+        if (rank == 1)
+            interpolator->lintet.interp_weights(node_indices, weights, atom.point, cell);
+        else if (rank == 2)
+            interpolator->quadtet.interp_weights(node_indices, weights, atom.point, cell);
+        else if (rank == 3)
+            interpolator->linhex.interp_weights(node_indices, weights, atom.point, cell);
+    }
+}
+
+void SolutionReader::calc_interp_matrix() {
+    const int n_atoms = size();
+    vector<vector<int>> node_indices(n_atoms);
+    vector<vector<double>> weights(n_atoms);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < n_atoms; ++i)
+        interp_weights(i, node_indices[i], weights[i]);
+
+    interp_matrix.clear();
+    interp_matrix.n_cols = interpolator->nodes.size();
+    interp_matrix.starts.resize(n_atoms + 1);
+    interp_matrix.starts[0] = 0;
+    for (int i = 0; i < n_atoms; ++i)
+        interp_matrix.starts[i+1] = interp_matrix.starts[i] + node_indices[i].size();
+
+    interp_matrix.cols.reserve(interp_matrix.starts[n_atoms]);
+    interp_matrix.vals.reserve(interp_matrix.starts[n_atoms]);
+    for (int i = 0; i < n_atoms; ++i) {
+        interp_matrix.cols.insert(interp_matrix.cols.end(), node_indices[i].begin(), node_indices[i].end());
+        interp_matrix.vals.insert(interp_matrix.vals.end(), weights[i].begin(), weights[i].end());
+    }
+}
+
+void SolutionReader::apply_interp_matrix() {
+    const vector<Solution> &solutions = *interpolator->nodes.get_solutions();
+    const vector<int> &starts = interp_matrix.starts;
+    const vector<int> &cols = interp_matrix.cols;
+    const vector<double> &vals = interp_matrix.vals;
+    const int n_atoms = size();
+
+    // vector and scalar data are interpolated in the same order as in interp_solution
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n_atoms; ++i) {
+        Vec3 vector_i(0.0);
+        double vector_norm_i(0.0);
+        double scalar_i(0.0);
+
+        for (int j = starts[i]; j < starts[i+1]; ++j) {
+            const Solution &s = solutions[cols[j]];
+            vector_i += s.vector * vals[j];
+            vector_norm_i += s.norm * vals[j];
+            scalar_i += s.scalar * vals[j];
+        }
+
+        interpolation[i] = Solution(vector_i, vector_norm_i, scalar_i);
+    }
+}
+
 void SolutionReader::calc_full_interpolation() {
     require(interpolator, "NULL interpolator cannot be used!");
     const int n_atoms = size();
@@ -160,6 +249,10 @@ void SolutionReader::calc_full_interpolation() {
     }
 
     atoms_mapped_to_cells = true;
+
+    // with sorting the cells of the atoms are not stored
+    if (sparse_interpolation && !sort_atoms)
+        calc_interp_matrix();
 }
 
 void SolutionReader::calc_interpolation() {
@@ -174,7 +267,15 @@ void SolutionReader::calc_interpolation() {
     }
 
     // ...yes, no need to calculate the mapping again, just interpolate
-    if (interp_centroids) {
+    if (!interp_matrix.empty()) {
+        // the matrix is useless if the points or the mesh have changed in size
+        if (interp_matrix.n_cols == interpolator->nodes.size() && (int) interp_matrix.starts.size() == n_atoms + 1)
+            apply_interp_matrix();
+        else
+            calc_full_interpolation();
+    }
+
+    else if (interp_centroids) {
         // #pragma omp parallel for
         for (int i = 0; i < n_atoms; ++i)
             interp_centroid(i);
@@ -194,6 +295,7 @@ void SolutionReader::reserve(const int n_nodes) {
     atoms.reserve(n_nodes);
     interpolation.resize(n_nodes);
     atoms_mapped_to_cells = false;
+    interp_matrix.clear();
 }
 
 void SolutionReader::write_xyz(ofstream &out) const {
@@ -488,6 +590,18 @@ void FieldReader::calc_interpolation() {
     }
 }
 
+void FieldReader::interpolate_dofs(PoissonSolver<3>& solver) {
+    solver.export_vertices(*this);
+    calc_interpolation();
+
+    const int n_points = size();
+    vector<double> potentials(n_points);
+    for (int i = 0; i < n_points; ++i)
+        potentials[i] = interpolation[i].scalar;
+
+    solver.import_solution(&potentials);
+}
+
 double FieldReader::get_analyt_potential(const int i, const Point3& origin) const {
     require(i >= 0 && i < size(), "Invalid index: " + to_string(i));
 
@@ -666,10 +780,15 @@ void HeatReader::interpolate_dofs(CurrentHeatSolver<3>& solver, const TetgenMesh
     // transfer temperatures and potentials into separate vectors
     const int n_points = size();
     temperatures.resize(n_points);
-    for (int i = 0; i < n_points; ++i)
+    potentials.resize(n_points);
+    for (int i = 0; i < n_points; ++i) {
         temperatures[i] = interpolation[i].scalar;
+        potentials[i] = interpolation[i].norm;
+    }
 
+    // current and heat solvers share the mesh and therefore also the vertex to dof mapping
     solver.heat.import_solution(&temperatures);
+    solver.current.import_solution(&potentials);
 }
 
 void HeatReader::precalc_berendsen(bool update_locations) {